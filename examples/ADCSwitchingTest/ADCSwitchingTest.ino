@@ -25,9 +25,10 @@
 
 #include <Arduino.h>
 
+#define USE_ADC_NOISE_REDUCTION_SLEEP // Enables readADCChannelWithReferenceSleep() for the noise benchmark
 #include "ADCUtils.hpp"
 
-#define VERSION_EXAMPLE "1.0"
+#define VERSION_EXAMPLE "1.1"
 
 #define CHANNEL_VCC_1_M_OHM     0
 #define CHANNEL_VCC_100_K_OHM   1
@@ -47,6 +48,7 @@ uint16_t ADCValueArray[ADC_ARRAY_SIZE];
 void printADCValueArray(uint16_t tAdditionalDelay = 0);
 void printADCVoltageValueArray(uint16_t tAdditionalDelay = 0);
 void doMeasurement(uint8_t aChannel, const __FlashStringHelper *aChannelString, bool aPrechargeWithVCC, uint16_t aDelay);
+void doSleepBenchmark();
 
 void setup() {
     // initialize the digital pin as an output.
@@ -87,6 +89,8 @@ void loop() {
     Serial.print(getVCCVoltageMillivolt());
     Serial.println(F("mv"));
 
+    doSleepBenchmark();
+
     uint8_t i;
 
     /*
@@ -396,3 +400,73 @@ void doMeasurement(uint8_t aChannel, const __FlashStringHelper *aChannelString,
     printADCValueArray(); // raw = 2803
 }
 
+#define BENCHMARK_NUMBER_OF_SAMPLES 256
+void printBenchmarkResult(const __FlashStringHelper *aModeString, uint16_t aMinimum, uint16_t aMaximum, uint32_t aSum,
+        uint32_t aMicros) {
+    Serial.print(aModeString);
+    Serial.print(F(" Min="));
+    Serial.print(aMinimum);
+    Serial.print(F(" Max="));
+    Serial.print(aMaximum);
+    Serial.print(F(" Spread="));
+    Serial.print(aMaximum - aMinimum);
+    Serial.print(F(" Average="));
+    Serial.print((float) aSum / BENCHMARK_NUMBER_OF_SAMPLES);
+    Serial.print(F(" Time per sample="));
+    Serial.print(aMicros / BENCHMARK_NUMBER_OF_SAMPLES);
+    Serial.println(F(" us"));
+}
+
+/*
+ * Compare noise and timing of busy wait and ADC noise reduction sleep conversions.
+ * Timer0 is stopped during sleep, so for sleep the time per sample is only the time the CPU is awake.
+ */
+void doSleepBenchmark() {
+    uint16_t tADCValue;
+    uint16_t tMinimum;
+    uint16_t tMaximum;
+    uint32_t tSum;
+    uint32_t tStartMicros;
+
+    Serial.println();
+    Serial.println(F("-------------------------"));
+    Serial.println(
+            F(
+                    "Compare " STR(BENCHMARK_NUMBER_OF_SAMPLES) " conversions of voltage divider at pin A" STR(CHANNEL_VOLTAGE_DIVIDER) " with INTERNAL reference."));
+    checkAndWaitForReferenceAndChannelToSwitch(CHANNEL_VOLTAGE_DIVIDER, INTERNAL);
+    Serial.flush(); // Serial interrupts would disturb the measurement
+
+    tMinimum = MAX_ADC_VALUE;
+    tMaximum = 0;
+    tSum = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BENCHMARK_NUMBER_OF_SAMPLES; ++i) {
+        tADCValue = readADCChannelWithReference(CHANNEL_VOLTAGE_DIVIDER, INTERNAL);
+        tSum += tADCValue;
+        if (tADCValue < tMinimum) {
+            tMinimum = tADCValue;
+        }
+        if (tADCValue > tMaximum) {
+            tMaximum = tADCValue;
+        }
+    }
+    printBenchmarkResult(F("Busy wait:"), tMinimum, tMaximum, tSum, micros() - tStartMicros);
+    Serial.flush();
+
+    tMinimum = MAX_ADC_VALUE;
+    tMaximum = 0;
+    tSum = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BENCHMARK_NUMBER_OF_SAMPLES; ++i) {
+        tADCValue = readADCChannelWithReferenceSleep(CHANNEL_VOLTAGE_DIVIDER, INTERNAL);
+        tSum += tADCValue;
+        if (tADCValue < tMinimum) {
+            tMinimum = tADCValue;
+        }
+        if (tADCValue > tMaximum) {
+            tMaximum = tADCValue;
+        }
+    }
+    printBenchmarkResult(F("Sleep:    "), tMinimum, tMaximum, tSum, micros() - tStartMicros);
+    Serial.println(F("For sleep, time per sample is only the awake time, since Timer0 is stopped during sleep."));
+}
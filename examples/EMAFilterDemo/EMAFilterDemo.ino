@@ -70,6 +70,11 @@
 //#define MAXIMUM_INPUT_VALUE 25     // here we see clipping effects due to the limited resolution of the used 16 bit math - picture 2 in readme
 uint16_t sMaximumInputValue = MAXIMUM_INPUT_VALUE;
 
+#if defined(MEASURE_TIMING)
+#define BLOCK_TIMING_NUMBER_OF_SAMPLES 128 // input and output buffer of doBlockTimingTest() require 512 bytes of stack
+void doBlockTimingTest();
+void doWindowFilterTimingTest();
+#endif
 uint8_t ReadFilterSelectionBCDValueFromPins();
 uint8_t ReadInputWaveformSelectionBCDValueFromPins();
 uint8_t sLastFilterSelection;
@@ -102,6 +107,10 @@ void setup() {
     doFiltersTimingTest(4711);
     delayMicroseconds(100);
     doFiltersTimingTest(-4711);
+#if defined(MEASURE_TIMING)
+    doBlockTimingTest();
+    doWindowFilterTimingTest();
+#endif
 
     // Print caption for Arduino Plotter
     printFiltersCaption(sLastFilterSelection);
@@ -296,3 +305,161 @@ uint8_t ReadInputWaveformSelectionBCDValueFromPins() {
     }
     return tSelection;
 }
+
+#if defined(MEASURE_TIMING)
+void printBlockTiming(const __FlashStringHelper *aFilterName, unsigned long aSingleMicros, unsigned long aBlockMicros) {
+    Serial.print(aFilterName);
+    Serial.print(F(" single="));
+    Serial.print(aSingleMicros);
+    Serial.print(F(" us block="));
+    Serial.print(aBlockMicros);
+    Serial.print(F(" us for "));
+    Serial.print(BLOCK_TIMING_NUMBER_OF_SAMPLES);
+    Serial.println(F(" samples"));
+}
+
+/*
+ * Compares the single value filter functions called in a loop with their block variants
+ */
+void doBlockTimingTest() {
+    int16_t tSamples[BLOCK_TIMING_NUMBER_OF_SAMPLES];
+    int16_t tOutputValues[BLOCK_TIMING_NUMBER_OF_SAMPLES]; // Not in place, so that each pair is measured with the same unfiltered input
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tSamples[i] = random(-1000, 1000);
+    }
+    unsigned long tSingleMicros;
+    unsigned long tStartMicros;
+
+    sLowpass3 = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpassShift_int16(&sLowpass3, tSamples[i], 3);
+    }
+    tSingleMicros = micros() - tStartMicros;
+    sLowpass3 = 0;
+    tStartMicros = micros();
+    doLowpassShift_int16_block(&sLowpass3, tSamples, tOutputValues, BLOCK_TIMING_NUMBER_OF_SAMPLES, 3);
+    printBlockTiming(F("LowpassShift_int16"), tSingleMicros, micros() - tStartMicros);
+
+    sLowpass2 = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpass_int16(&sLowpass2, tSamples[i], 64);
+    }
+    tSingleMicros = micros() - tStartMicros;
+    sLowpass2 = 0;
+    tStartMicros = micros();
+    doLowpass_int16_block(&sLowpass2, tSamples, tOutputValues, BLOCK_TIMING_NUMBER_OF_SAMPLES, 64);
+    printBlockTiming(F("Lowpass_int16"), tSingleMicros, micros() - tStartMicros);
+
+    sLowpass5_int32_shift8 = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpassShift_int32_shift8(&sLowpass5_int32_shift8, tSamples[i], 5);
+    }
+    tSingleMicros = micros() - tStartMicros;
+    sLowpass5_int32_shift8 = 0;
+    tStartMicros = micros();
+    doLowpassShift_int32_shift8_block(&sLowpass5_int32_shift8, tSamples, tOutputValues, BLOCK_TIMING_NUMBER_OF_SAMPLES, 5);
+    printBlockTiming(F("LowpassShift_int32_shift8"), tSingleMicros, micros() - tStartMicros);
+
+    sLowpass8_int32_shift8 = 0;
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpass_int32_shift8(&sLowpass8_int32_shift8, tSamples[i], 8);
+    }
+    tSingleMicros = micros() - tStartMicros;
+    sLowpass8_int32_shift8 = 0;
+    tStartMicros = micros();
+    doLowpass_int32_shift8_block(&sLowpass8_int32_shift8, tSamples, tOutputValues, BLOCK_TIMING_NUMBER_OF_SAMPLES, 8);
+    printBlockTiming(F("Lowpass_int32_shift8"), tSingleMicros, micros() - tStartMicros);
+
+    EMALowpassCascade<int16_t, 3, 3> tTripleLowpass3;
+    tTripleLowpass3.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tTripleLowpass3.update(tSamples[i]);
+    }
+    tSingleMicros = micros() - tStartMicros;
+    tTripleLowpass3.reset();
+    tStartMicros = micros();
+    tTripleLowpass3.updateBlock(tSamples, tOutputValues, BLOCK_TIMING_NUMBER_OF_SAMPLES);
+    printBlockTiming(F("TripleLowpass3_int16"), tSingleMicros, micros() - tStartMicros);
+
+    resetFilters();
+}
+
+/*
+ * Prints memory and cycles per sample of the window filters, compared with the EMA filters
+ */
+void printWindowFilterTiming(const __FlashStringHelper *aFilterName, uint16_t aSizeOfInstance, unsigned long aMicros) {
+    Serial.print(aFilterName);
+    Serial.print(F(" size="));
+    Serial.print(aSizeOfInstance);
+    Serial.print(F(" bytes "));
+    Serial.print((aMicros * (F_CPU / 1000000L)) / BLOCK_TIMING_NUMBER_OF_SAMPLES);
+    Serial.println(F(" cycles per sample"));
+}
+
+void doWindowFilterTimingTest() {
+    int16_t tSamples[BLOCK_TIMING_NUMBER_OF_SAMPLES];
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tSamples[i] = random(-1000, 1000);
+    }
+    unsigned long tStartMicros;
+
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpassShift_int16(&sLowpass3, tSamples[i], 3);
+    }
+    printWindowFilterTiming(F("LowpassShift_int16"), sizeof(sLowpass3), micros() - tStartMicros);
+
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        doLowpass_int32_shift8(&sLowpass8_int32_shift8, tSamples[i], 8);
+    }
+    printWindowFilterTiming(F("Lowpass_int32_shift8"), sizeof(sLowpass8_int32_shift8), micros() - tStartMicros);
+
+    MovingAverageFilter<4> tMovingAverage16;
+    tMovingAverage16.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tMovingAverage16.update(tSamples[i]);
+    }
+    printWindowFilterTiming(F("MovingAverage16"), sizeof(tMovingAverage16), micros() - tStartMicros);
+
+    MedianFilter<3> tMedian3;
+    tMedian3.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tMedian3.update(tSamples[i]);
+    }
+    printWindowFilterTiming(F("Median3"), sizeof(tMedian3), micros() - tStartMicros);
+
+    MedianFilter<5> tMedian5;
+    tMedian5.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tMedian5.update(tSamples[i]);
+    }
+    printWindowFilterTiming(F("Median5"), sizeof(tMedian5), micros() - tStartMicros);
+
+    MedianFilter<7> tMedian7;
+    tMedian7.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tMedian7.update(tSamples[i]);
+    }
+    printWindowFilterTiming(F("Median7"), sizeof(tMedian7), micros() - tStartMicros);
+
+    MedianFilter<15> tMedian15;
+    tMedian15.reset();
+    tStartMicros = micros();
+    for (uint16_t i = 0; i < BLOCK_TIMING_NUMBER_OF_SAMPLES; ++i) {
+        tMedian15.update(tSamples[i]);
+    }
+    printWindowFilterTiming(F("Median15"), sizeof(tMedian15), micros() - tStartMicros);
+
+    resetFilters();
+}
+#endif
@@ -0,0 +1,394 @@
+/*
+ *  ADCUtilsTest.cpp
+ *
+ *  Host unit tests for ADCUtils, using the ADC register simulation of ADCSimulation.h.
+ *  All results are deterministic, since time and ADC values are simulated.
+ *
+ *  Compile and run on Linux with:
+ *  g++ -O2 -std=gnu++11 -Wall -I../../src ADCUtilsTest.cpp -o ADCUtilsTest -lm && ./ADCUtilsTest
+ *  Returns the number of failed checks as exit code.
+ *
+ *  Copyright (C) 2026  Armin Joachimsmeyer
+ *  Email: armin.joachimsmeyer@gmail.com
+ *
+ *  This file is part of Arduino-Utils https://github.com/ArminJo/Arduino-Utils.
+ *
+ *  Arduino-Utils is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#define USE_ADC_SIMULATION
+#define USE_ADC_SAMPLER
+#define USE_ADC_NOISE_REDUCTION_SLEEP
+#include "ADCUtils.hpp"
+
+uint16_t sNumberOfChecks;
+uint16_t sNumberOfFailedChecks;
+
+void checkEqual(const char *aCheckName, long aActualValue, long aExpectedValue) {
+    sNumberOfChecks++;
+    if (aActualValue != aExpectedValue) {
+        sNumberOfFailedChecks++;
+        printf("FAILED %s: %ld, expected %ld\n", aCheckName, aActualValue, aExpectedValue);
+    }
+}
+
+void checkNear(const char *aCheckName, double aActualValue, double aExpectedValue, double aTolerance) {
+    sNumberOfChecks++;
+    if (fabs(aActualValue - aExpectedValue) > aTolerance) {
+        sNumberOfFailedChecks++;
+        printf("FAILED %s: %.2f, expected %.2f +/- %.2f\n", aCheckName, aActualValue, aExpectedValue, aTolerance);
+    }
+}
+
+/*
+ * Ring buffer and overrun accounting of the sampler, fed directly by storeADCSamplerValue()
+ */
+void testADCSamplerRingBuffer() {
+    uint16_t tValue = 0;
+    sADCSamplerWriteIndex = 0;
+    sADCSamplerReadIndex = 0;
+    getAndResetADCSamplerOverrunCount();
+
+    checkEqual("Sampler empty read", readADCSampler(&tValue), false);
+    checkEqual("Sampler empty peek", peekADCSampler(&tValue), false);
+
+    // Fill
+    for (uint16_t i = 0; i < ADC_SAMPLER_BUFFER_SIZE; ++i) {
+        storeADCSamplerValue(i);
+    }
+    checkEqual("Sampler full available", getADCSamplerNumberOfAvailableSamples(), ADC_SAMPLER_BUFFER_SIZE);
+    checkEqual("Sampler full overruns", sADCSamplerOverrunCount, 0);
+    storeADCSamplerValue(4711);
+    storeADCSamplerValue(4712);
+    checkEqual("Sampler overrun available", getADCSamplerNumberOfAvailableSamples(), ADC_SAMPLER_BUFFER_SIZE);
+    checkEqual("Sampler overrun count", getAndResetADCSamplerOverrunCount(), 2);
+    checkEqual("Sampler overrun count after reset", getAndResetADCSamplerOverrunCount(), 0);
+
+    // Peek does not remove, read does
+    checkEqual("Sampler peek", peekADCSampler(&tValue), true);
+    checkEqual("Sampler peek value", tValue, 0);
+    checkEqual("Sampler peek value again", peekADCSampler(&tValue) ? tValue : -1, 0);
+    checkEqual("Sampler read", readADCSampler(&tValue), true);
+    checkEqual("Sampler read value", tValue, 0);
+    checkEqual("Sampler read next value", readADCSampler(&tValue) ? tValue : -1, 1);
+    checkEqual("Sampler available after 2 reads", getADCSamplerNumberOfAvailableSamples(), ADC_SAMPLER_BUFFER_SIZE - 2);
+
+    // Drain, dropped values must not appear
+    uint16_t tNumberOfReads = 0;
+    uint16_t tLastValue = 1;
+    while (readADCSampler(&tValue)) {
+        tNumberOfReads++;
+        tLastValue = tValue;
+    }
+    checkEqual("Sampler drain reads", tNumberOfReads, ADC_SAMPLER_BUFFER_SIZE - 2);
+    checkEqual("Sampler drain last value", tLastValue, ADC_SAMPLER_BUFFER_SIZE - 1);
+
+    // Wrap of the free running uint8_t indexes
+    uint16_t tNumberOfErrors = 0;
+    for (uint16_t i = 0; i < 1000; ++i) {
+        storeADCSamplerValue(i);
+        storeADCSamplerValue(i + 10000);
+        if (getADCSamplerNumberOfAvailableSamples() != 2 || !readADCSampler(&tValue) || tValue != i || !readADCSampler(&tValue)
+                || tValue != i + 10000) {
+            tNumberOfErrors++;
+        }
+    }
+    checkEqual("Sampler wrap errors", tNumberOfErrors, 0);
+    checkEqual("Sampler wrap write index", sADCSamplerWriteIndex, (ADC_SAMPLER_BUFFER_SIZE + 2000) & 0xFF);
+    checkEqual("Sampler wrap read index", sADCSamplerReadIndex, sADCSamplerWriteIndex);
+    checkEqual("Sampler wrap overruns", getAndResetADCSamplerOverrunCount(), 0);
+
+    // Overrun accounting of a wrapped buffer
+    for (uint16_t i = 0; i < 100; ++i) {
+        storeADCSamplerValue(i);
+    }
+    tNumberOfReads = 0;
+    while (readADCSampler(&tValue)) {
+        tNumberOfReads++;
+    }
+    checkEqual("Sampler 100 values reads", tNumberOfReads, ADC_SAMPLER_BUFFER_SIZE);
+    checkEqual("Sampler 100 values overruns", getAndResetADCSamplerOverrunCount(), 100 - ADC_SAMPLER_BUFFER_SIZE);
+}
+
+/*
+ * Sampler fed by the simulated free running ADC and its ISR
+ */
+const uint16_t sRampScript[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+void testADCSamplerISR() {
+    uint16_t tValue = 0;
+    resetADCSimulation();
+    setADCSimulationScript(sRampScript, sizeof(sRampScript) / sizeof(sRampScript[0]), true);
+    startADCSampler(0, DEFAULT, ADC_PRESCALE128); // 104 us per conversion
+    advanceADCSimulationMicros(104L * 20 + 100); // 1 conversion of 25 clocks and at least 19 of 13
+    stopADCSampler();
+    uint16_t tNumberOfSamples = getADCSamplerNumberOfAvailableSamples();
+    checkEqual("Sampler ISR number of samples", tNumberOfSamples, 20);
+    uint16_t tNumberOfErrors = 0;
+    for (uint16_t i = 0; i < tNumberOfSamples; ++i) {
+        if (!readADCSampler(&tValue) || tValue != i % 10) {
+            tNumberOfErrors++;
+        }
+    }
+    checkEqual("Sampler ISR value errors", tNumberOfErrors, 0);
+
+    // No reads, so the buffer overruns
+    startADCSampler(0, DEFAULT, ADC_PRESCALE128);
+    advanceADCSimulationMicros(104L * (ADC_SAMPLER_BUFFER_SIZE + 10));
+    stopADCSampler();
+    checkEqual("Sampler ISR full", getADCSamplerNumberOfAvailableSamples(), ADC_SAMPLER_BUFFER_SIZE);
+    checkEqual("Sampler ISR overruns", getAndResetADCSamplerOverrunCount() > 0, true);
+    setADCSimulationScript(NULL, 0, false);
+}
+
+/*
+ * Entries above ADC_SCAN_LIST_MAX_ENTRIES must not be read
+ */
+void testADCScanListLimit() {
+    resetADCSimulation();
+    for (uint_fast8_t i = 0; i < 8; ++i) {
+        sADCSimulation.ChannelMillivolt[i] = 500 * i;
+    }
+    ADCScanChannelStruct tScanList[ADC_SCAN_LIST_MAX_ENTRIES + 1];
+    for (uint_fast8_t i = 0; i <= ADC_SCAN_LIST_MAX_ENTRIES; ++i) {
+        ADCScanChannelStruct tEntry = ADC_SCAN_ENTRY(i % 8, DEFAULT, 0);
+        tScanList[i] = tEntry;
+        tScanList[i].Result = 4711;
+    }
+    readADCScanList(tScanList, ADC_SCAN_LIST_MAX_ENTRIES + 1, ADC_PRESCALE32);
+    checkEqual("Scan list channel 1", tScanList[1].Result, (500L * 1024) / 5000);
+    checkEqual("Scan list last entry", tScanList[ADC_SCAN_LIST_MAX_ENTRIES - 1].Result,
+            (500L * ((ADC_SCAN_LIST_MAX_ENTRIES - 1) % 8) * 1024) / 5000);
+    checkEqual("Scan list entry above maximum", tScanList[ADC_SCAN_LIST_MAX_ENTRIES].Result, 4711);
+
+    // Oversample exponent above maximum is clamped
+    ADCScanChannelStruct tOversampleScanList[] = { ADC_SCAN_ENTRY(2, DEFAULT, 8), ADC_SCAN_ENTRY(3, DEFAULT, 0) };
+    uint32_t tNumberOfConversions = sADCSimulation.NumberOfConversions;
+    readADCScanList(tOversampleScanList, 2, ADC_PRESCALE32);
+    checkEqual("Scan list oversample exponent clamped", tOversampleScanList[0].OversampleExponent, ADC_SCAN_MAX_OVERSAMPLE_EXPONENT);
+    checkEqual("Scan list oversample above maximum", tOversampleScanList[0].Result, (1000L * 1024) / 5000);
+    checkEqual("Scan list entry after oversample", tOversampleScanList[1].Result, (1500L * 1024) / 5000);
+    checkNear("Scan list oversample conversions", sADCSimulation.NumberOfConversions - tNumberOfConversions,
+            _BV(ADC_SCAN_MAX_OVERSAMPLE_EXPONENT) + 1, 3);
+}
+
+/*
+ * Statistics for a sine compared with a double precision reference of the same samples
+ */
+#define STATISTICS_SINE_SAMPLES 1000
+void testADCStatisticsSine() {
+    ADCStatisticsStruct tStatistics;
+    initADCStatistics(&tStatistics, 512, 0);
+    double tSum = 0;
+    double tSumOfSquares = 0;
+    uint16_t tMinimum = MAX_ADC_VALUE;
+    uint16_t tMaximum = 0;
+    for (uint16_t i = 0; i < STATISTICS_SINE_SAMPLES; ++i) {
+        uint16_t tADCValue = lround(530 + 400 * sin(TWO_PI * i / 97.3)); // 530 to get a DC part
+        addADCStatisticsSample(&tStatistics, tADCValue);
+        tSum += tADCValue;
+        tSumOfSquares += (tADCValue - 512.0) * (tADCValue - 512.0);
+        if (tMinimum > tADCValue) {
+            tMinimum = tADCValue;
+        }
+        if (tMaximum < tADCValue) {
+            tMaximum = tADCValue;
+        }
+    }
+    double tMean = tSum / STATISTICS_SINE_SAMPLES;
+    double tRMS = sqrt(tSumOfSquares / STATISTICS_SINE_SAMPLES);
+    double tACRMS = sqrt(tSumOfSquares / STATISTICS_SINE_SAMPLES - (tMean - 512) * (tMean - 512));
+    checkEqual("Statistics sine number of samples", tStatistics.NumberOfSamples, STATISTICS_SINE_SAMPLES);
+    checkNear("Statistics sine mean", getADCStatisticsMean_shift4(&tStatistics) / 16.0, tMean, 1.0 / 16);
+    checkNear("Statistics sine RMS", getADCStatisticsRMS_shift4(&tStatistics) / 16.0, tRMS, 1.0 / 16);
+    checkNear("Statistics sine AC RMS", getADCStatisticsACRMS_shift4(&tStatistics) / 16.0, tACRMS, 1.0 / 16);
+    checkEqual("Statistics sine peak to peak", getADCStatisticsPeakToPeak(&tStatistics), tMaximum - tMinimum);
+    checkEqual("Statistics sine zero crossings", tStatistics.NumberOfZeroCrossings, 20);
+}
+
+/*
+ * 50 Hz sine with 1 volt amplitude at channel 0, sampled by the simulated ADC
+ */
+uint16_t getSine50HzADCValue(uint8_t aADCChannelNumber __attribute__((unused)), uint8_t aReference __attribute__((unused)),
+        unsigned long aMicros) {
+    return lround(512 + 204.8 * sin(TWO_PI * 50 * aMicros / 1000000.0 + 1.0)); // 1.0 to start not at a zero crossing
+}
+
+/*
+ * Acquisition synchronized to 5 periods of 50 Hz by readADCStatistics()
+ */
+void testADCStatisticsPeriodSync() {
+    ADCStatisticsStruct tStatistics;
+    resetADCSimulation();
+    setADCSimulationSourceFunction(getSine50HzADCValue);
+    initADCStatistics(&tStatistics, 512, 5);
+    readADCStatistics(&tStatistics, 0, DEFAULT, ADC_PRESCALE128, 2000);
+    setADCSimulationSourceFunction(NULL);
+
+    checkEqual("Statistics sync finished", tStatistics.State, ADC_STATISTICS_STATE_FINISHED);
+    checkEqual("Statistics sync periods", tStatistics.NumberOfPeriodsAcquired, 5);
+    // 104 us per sample gives 192.3 samples per period
+    checkNear("Statistics sync number of samples", tStatistics.NumberOfSamples, 5 * 192.3, 2);
+    checkEqual("Statistics sync zero crossings", tStatistics.NumberOfZeroCrossings, 10); // including the rising one, which ends acquisition
+    checkNear("Statistics sync mean", getADCStatisticsMean_shift4(&tStatistics) / 16.0, 512, 0.5);
+    checkNear("Statistics sync AC RMS", getADCStatisticsACRMS_shift4(&tStatistics) / 16.0, 204.8 / sqrt(2), 0.5);
+    checkNear("Statistics sync peak to peak", getADCStatisticsPeakToPeak(&tStatistics), 2 * 204.8, 2);
+    checkNear("Statistics sync millivolt", getMillivoltFromADCValue_shift4(getADCStatisticsACRMS_shift4(&tStatistics), 5000),
+            1000 / sqrt(2), 3);
+}
+
+/*
+ * Maximum deviation for the maximum number of samples must not overflow SumOfSquares
+ */
+void testADCStatisticsOverflow() {
+    ADCStatisticsStruct tStatistics;
+    initADCStatistics(&tStatistics, 512, 0);
+    while (!addADCStatisticsSample(&tStatistics, 0)) {
+    }
+    checkEqual("Statistics 512 max samples", tStatistics.NumberOfSamples, ADC_STATISTICS_MAX_NUMBER_OF_SAMPLES);
+    checkEqual("Statistics 512 RMS", getADCStatisticsRMS_shift4(&tStatistics), 512 * 16);
+    checkEqual("Statistics 512 AC RMS", getADCStatisticsACRMS_shift4(&tStatistics), 0);
+
+    initADCStatistics(&tStatistics, 0, 0);
+    while (!addADCStatisticsSample(&tStatistics, MAX_ADC_VALUE)) {
+    }
+    checkEqual("Statistics 0 max samples", tStatistics.NumberOfSamples, 0xFFFFFFFF / (1023L * 1023));
+    checkEqual("Statistics 0 RMS", getADCStatisticsRMS_shift4(&tStatistics), 1023 * 16);
+    checkEqual("Statistics 0 mean", getADCStatisticsMean_shift4(&tStatistics), 1023 * 16);
+
+    initADCStatistics(&tStatistics, 1023, 0);
+    while (!addADCStatisticsSample(&tStatistics, 0)) {
+    }
+    checkEqual("Statistics 1023 RMS", getADCStatisticsRMS_shift4(&tStatistics), 1023 * 16);
+}
+
+/*
+ * A conversion, which is running while the model or the script is changed, still returns the old value, like the real ADC.
+ * So wait for it to end before reading a new value.
+ */
+void waitForRunningConversion() {
+    delay(1);
+}
+
+/*
+ * Oversampling from model with noise and from a script
+ */
+const uint16_t sOversampleScript[] = { 100, 101, 102, 103 };
+void testReadADCChannelWithReferenceOversample() {
+    resetADCSimulation();
+    sADCSimulation.ChannelMillivolt[2] = 2500;
+    checkEqual("Oversample model", readADCChannelWithReferenceOversample(2, DEFAULT, 4), 512);
+    waitForRunningConversion();
+    checkEqual("Oversample model 1.1 volt reference", readADCChannelWithReferenceOversample(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 2),
+            (1100L * 1024) / 5000);
+    sADCSimulation.NoiseAmplitudeRaw = 3;
+    waitForRunningConversion();
+    checkNear("Oversample model with noise", readADCChannelWithReferenceOversample(2, DEFAULT, 6), 512, 1);
+
+    resetADCSimulation();
+    setADCSimulationScript(sOversampleScript, 4, true);
+    checkEqual("Oversample script", readADCChannelWithReferenceOversample(0, DEFAULT, 2), (406 + 2) / 4);
+    checkEqual("Oversample script conversions", sADCSimulation.NumberOfConversions, 4);
+    setADCSimulationScript(NULL, 0, false);
+}
+
+/*
+ * Undervoltage is signaled once after VCC_UNDERVOLTAGE_CHECKS_BEFORE_STOP checks, emergency undervoltage at the first check
+ */
+void testIsVCCUndervoltageMultipleTimes() {
+    resetADCSimulation();
+    sVCCTooLowCounter = 0;
+    sLastVCCCheckMillis = 0;
+    sADCSimulation.VCCMillivolt = VCC_UNDERVOLTAGE_THRESHOLD_MILLIVOLT - 100;
+    uint8_t tNumberOfTrueResults = 0;
+    uint8_t tCheckOfFirstTrueResult = 0;
+    for (uint8_t i = 1; i <= 2 * VCC_UNDERVOLTAGE_CHECKS_BEFORE_STOP; ++i) {
+        checkEqual("Undervoltage no check before period", isVCCUndervoltageMultipleTimes(), false);
+        delay(VCC_CHECK_PERIOD_MILLIS + 1);
+        if (isVCCUndervoltageMultipleTimes()) {
+            tNumberOfTrueResults++;
+            if (tCheckOfFirstTrueResult == 0) {
+                tCheckOfFirstTrueResult = i;
+            }
+        }
+    }
+    checkNear("Undervoltage measured VCC", sVCCVoltageMillivolt, VCC_UNDERVOLTAGE_THRESHOLD_MILLIVOLT - 100, 10);
+    checkEqual("Undervoltage number of true results", tNumberOfTrueResults, 1);
+    checkEqual("Undervoltage check of true result", tCheckOfFirstTrueResult, VCC_UNDERVOLTAGE_CHECKS_BEFORE_STOP);
+
+    // Recovery resets the counter
+    sVCCTooLowCounter = 0;
+    for (uint8_t i = 0; i < VCC_UNDERVOLTAGE_CHECKS_BEFORE_STOP - 1; ++i) {
+        delay(VCC_CHECK_PERIOD_MILLIS + 1);
+        isVCCUndervoltageMultipleTimes();
+    }
+    sADCSimulation.VCCMillivolt = 5000;
+    delay(VCC_CHECK_PERIOD_MILLIS + 1);
+    checkEqual("Undervoltage recovered", isVCCUndervoltageMultipleTimes(), false);
+    checkEqual("Undervoltage recovered counter", sVCCTooLowCounter, 0);
+
+    sADCSimulation.VCCMillivolt = VCC_EMERGENCY_UNDERVOLTAGE_THRESHOLD_MILLIVOLT - 100;
+    delay(VCC_CHECK_PERIOD_MILLIS + 1);
+    checkEqual("Emergency undervoltage", isVCCUndervoltageMultipleTimes(), true);
+}
+
+/*
+ * Temperature from the model and from a script of raw values
+ */
+const uint16_t sTemperatureScript[] = { 378 }; // 317 + 1.22 * 50 degree
+void testGetCPUTemperature() {
+    resetADCSimulation();
+    sADCSimulation.TemperatureCentiDegree = 2500;
+    checkNear("Temperature model 25", getCPUTemperature(), 25, 1);
+    sADCSimulation.TemperatureCentiDegree = -1000;
+    waitForRunningConversion();
+    checkNear("Temperature model -10", getCPUTemperature(), -10, 1);
+
+    setADCSimulationScript(sTemperatureScript, 1, true);
+    waitForRunningConversion();
+    checkNear("Temperature script 50", getCPUTemperature(), 50, 1);
+    setADCSimulationScript(NULL, 0, false);
+}
+
+/*
+ * Entering ADC noise reduction sleep mode must start a new conversion for the selected channel
+ */
+void testReadADCChannelWithReferenceSleep() {
+    resetADCSimulation();
+    sADCSimulation.ChannelMillivolt[0] = 2500;
+    sADCSimulation.ChannelMillivolt[1] = 1000;
+    checkEqual("Sleep channel 0 busy wait", readADCChannelWithReference(0, DEFAULT), 512);
+    checkEqual("Sleep channel 1", readADCChannelWithReferenceSleep(1, DEFAULT), (1000L * 1024) / 5000);
+    checkEqual("Sleep channel 0", readADCChannelWithReferenceSleep(0, DEFAULT), 512);
+    checkEqual("Sleep oversample channel 1", readADCChannelWithReferenceOversampleSleep(1, DEFAULT, 2), (1000L * 1024) / 5000);
+    checkEqual("Sleep oversample channel 0", readADCChannelWithReferenceOversampleSleep(0, DEFAULT, 2), 512);
+    checkEqual("Sleep conversions", sADCSimulation.NumberOfConversions, 1 + 2 + 4 + 4);
+    checkEqual("Sleep restores ADIE", ADCSRA & _BV(ADIE), 0);
+}
+
+int main() {
+    testADCSamplerRingBuffer();
+    testADCSamplerISR();
+    testADCScanListLimit();
+    testADCStatisticsSine();
+    testADCStatisticsPeriodSync();
+    testADCStatisticsOverflow();
+    testReadADCChannelWithReferenceOversample();
+    testIsVCCUndervoltageMultipleTimes();
+    testGetCPUTemperature();
+    testReadADCChannelWithReferenceSleep();
+
+    printf("%u of %u checks failed\n", sNumberOfFailedChecks, sNumberOfChecks);
+    return sNumberOfFailedChecks;
+}
@@ -0,0 +1,564 @@
+/*
+ *  FilterBenchmark.cpp
+ *
+ *  Host program to compare the filters of SimpleEMAFilters.hpp with data instead of plots.
+ *  Each filter is fed with step, impulse, chirp and noise signals and compared with a double precision reference
+ *  of the same filter. Reported are:
+ *  - Step response: samples to reach 50 % and 90 % of the step and the final value, which shows dead bands of the 16 bit math.
+ *  - Impulse response: sum (DC gain) and number of samples until the output stays at 0.
+ *  - Attenuation in dB for sines of the given frequencies.
+ *  - Quantization error: maximum and RMS difference to the reference for chirp and noise.
+ *  - Nanoseconds per sample on the host. Only the ratios between filters are meaningful for AVR.
+ *
+ *  Compile and run on Linux with:
+ *  g++ -O2 -std=gnu++11 -Wall -I../../src FilterBenchmark.cpp -o FilterBenchmark -lm
+ *  ./FilterBenchmark [<Frequency in Hz for attenuation>...]
+ *  The sample frequency is 1 kHz.
+ *
+ *  Copyright (C) 2026  Armin Joachimsmeyer
+ *  Email: armin.joachimsmeyer@gmail.com
+ *
+ *  This file is part of Arduino-Utils https://github.com/ArminJo/Arduino-Utils.
+ *
+ *  Arduino-Utils is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#define USE_ADC_SIMULATION
+#include "SimpleEMAFilters.hpp"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define SAMPLE_FREQUENCY_HERTZ      1000
+#define SIGNAL_AMPLITUDE            1000 // Like a 10 bit ADC value
+#define NUMBER_OF_SAMPLES           4000 // For step, impulse, chirp and noise
+#define ATTENUATION_SAMPLES         4000 // The first half is settling time, the RMS is taken from the second half
+#define TIMING_SAMPLES              1000000L
+#define MAXIMUM_NUMBER_OF_FREQUENCIES 16
+
+/*
+ * Each filter under test is accessed by 2 functions, one for the library filter and one for the double reference
+ */
+struct FilterUnderTestStruct {
+    const char *Name;
+    void (*ResetFunction)();
+    int16_t (*StepFunction)(int16_t aInputValue);
+    void (*ResetReferenceFunction)();
+    double (*ReferenceStepFunction)(double aInputValue);
+};
+
+/*
+ * Double precision reference filters
+ */
+struct ReferenceLowpassCascadeStruct {
+    double Alpha;
+    uint8_t Stages;
+    double Values[3];
+};
+double doReferenceLowpassCascade(struct ReferenceLowpassCascadeStruct *aFilterPtr, double aInputValue) {
+    for (uint_fast8_t i = 0; i < aFilterPtr->Stages; ++i) {
+        aFilterPtr->Values[i] += (aInputValue - aFilterPtr->Values[i]) * aFilterPtr->Alpha;
+        aInputValue = aFilterPtr->Values[i];
+    }
+    return aInputValue;
+}
+void resetReferenceLowpassCascade(struct ReferenceLowpassCascadeStruct *aFilterPtr, double aAlpha, uint8_t aStages) {
+    aFilterPtr->Alpha = aAlpha;
+    aFilterPtr->Stages = aStages;
+    memset(aFilterPtr->Values, 0, sizeof(aFilterPtr->Values));
+}
+
+/*
+ * State variable filter with the quantized coefficients of doBiquad_int16() and doBiquad_int32()
+ */
+struct ReferenceStateVariableFilterStruct {
+    double Alpha;
+    double DampingFactor;
+    double Lowpass;
+    double Bandpass;
+};
+double doReferenceStateVariableFilter(struct ReferenceStateVariableFilterStruct *aFilterPtr, double aInputValue) {
+    double tHighpass = aInputValue - aFilterPtr->Bandpass * aFilterPtr->DampingFactor - aFilterPtr->Lowpass;
+    aFilterPtr->Bandpass += tHighpass * aFilterPtr->Alpha;
+    aFilterPtr->Lowpass += aFilterPtr->Bandpass * aFilterPtr->Alpha;
+    return aFilterPtr->Lowpass;
+}
+
+/*
+ * Direct form I with the unquantized coefficients
+ */
+struct ReferenceBiquadStruct {
+    struct BiquadCoefficientsStruct Coefficients;
+    double X1, X2, Y1, Y2;
+};
+double doReferenceBiquad(struct ReferenceBiquadStruct *aFilterPtr, double aInputValue) {
+    double tOutputValue = aFilterPtr->Coefficients.b0 * aInputValue + aFilterPtr->Coefficients.b1 * aFilterPtr->X1
+            + aFilterPtr->Coefficients.b2 * aFilterPtr->X2 - aFilterPtr->Coefficients.a1 * aFilterPtr->Y1
+            - aFilterPtr->Coefficients.a2 * aFilterPtr->Y2;
+    aFilterPtr->X2 = aFilterPtr->X1;
+    aFilterPtr->X1 = aInputValue;
+    aFilterPtr->Y2 = aFilterPtr->Y1;
+    aFilterPtr->Y1 = tOutputValue;
+    return tOutputValue;
+}
+void resetReferenceBiquad(struct ReferenceBiquadStruct *aFilterPtr) {
+    aFilterPtr->X1 = 0;
+    aFilterPtr->X2 = 0;
+    aFilterPtr->Y1 = 0;
+    aFilterPtr->Y2 = 0;
+}
+
+/*
+ * Filter parameters. 20 Hz is the cutoff for the biquads, shift 3 and alpha 32 / 256 are around 20 Hz for the EMA filters.
+ */
+#define EMA_SHIFT                   3
+#define EMA_ALPHA_SHIFT8            32
+#define BIQUAD_CUTOFF_HERTZ         20
+#define BIQUAD_Q                    0.707
+#define NOTCH_FREQUENCY_HERTZ       50
+#define NOTCH_Q                     10
+
+/*
+ * Library filter states
+ */
+int16_t sBenchmarkLowpass_int16;
+int32_t sBenchmarkLowpass_int32_shift8;
+int32_t sBenchmarkLowpass_int32_shift16;
+EMALowpassCascade<int16_t, EMA_SHIFT, 3> sBenchmarkTripleLowpass;
+EMALowpassCascade<int32_t, EMA_SHIFT, 2> sBenchmarkDoubleLowpass_int32;
+struct BiquadFilter16Struct sBenchmarkBiquad16;
+struct BiquadFilter32Struct sBenchmarkBiquad32;
+struct BiquadDF1Q15Struct sBenchmarkButterworthDF1_Q15[2];
+struct BiquadDF2TQ15Struct sBenchmarkButterworthDF2T_Q15[2];
+struct BiquadDF1Q31Struct sBenchmarkButterworthDF1_Q31[2];
+struct BiquadDF2TQ31Struct sBenchmarkButterworthDF2T_Q31[2];
+struct BiquadDF2TQ15Struct sBenchmarkNotch_Q15;
+MovingAverageFilter<4> sBenchmarkMovingAverage16;
+MedianFilter<5> sBenchmarkMedian5;
+MedianFilter<15> sBenchmarkMedian15;
+
+/*
+ * Reference filter states
+ */
+struct ReferenceLowpassCascadeStruct sReferenceLowpassCascade;
+struct ReferenceStateVariableFilterStruct sReferenceStateVariableFilter;
+struct ReferenceBiquadStruct sReferenceButterworth[2];
+struct ReferenceBiquadStruct sReferenceNotch;
+double sReferenceWindow[16]; // For moving average and median
+uint8_t sReferenceWindowIndex;
+
+/*
+ * Library filter functions
+ */
+void resetLowpass_int16() {
+    sBenchmarkLowpass_int16 = 0;
+}
+int16_t doLowpassShift_int16_step(int16_t aInputValue) {
+    doLowpassShift_int16(&sBenchmarkLowpass_int16, aInputValue, EMA_SHIFT);
+    return sBenchmarkLowpass_int16;
+}
+int16_t doLowpass_int16_step(int16_t aInputValue) {
+    doLowpass_int16(&sBenchmarkLowpass_int16, aInputValue, EMA_ALPHA_SHIFT8);
+    return sBenchmarkLowpass_int16;
+}
+void resetLowpass_int32_shift8() {
+    sBenchmarkLowpass_int32_shift8 = 0;
+}
+int16_t doLowpassShift_int32_shift8_step(int16_t aInputValue) {
+    doLowpassShift_int32_shift8(&sBenchmarkLowpass_int32_shift8, aInputValue, EMA_SHIFT);
+    return sBenchmarkLowpass_int32_shift8 >> 8;
+}
+int16_t doLowpass_int32_shift8_step(int16_t aInputValue) {
+    doLowpass_int32_shift8(&sBenchmarkLowpass_int32_shift8, aInputValue, EMA_ALPHA_SHIFT8);
+    return sBenchmarkLowpass_int32_shift8 >> 8;
+}
+void resetLowpass_int32_shift16() {
+    sBenchmarkLowpass_int32_shift16 = 0;
+}
+int16_t doLowpass_int32_shift16_step(int16_t aInputValue) {
+    doLowpass_int32_shift16(&sBenchmarkLowpass_int32_shift16, aInputValue, EMA_SHIFT);
+    return sBenchmarkLowpass_int32_shift16 >> 16;
+}
+void resetTripleLowpass() {
+    sBenchmarkTripleLowpass.reset();
+}
+int16_t doTripleLowpass_step(int16_t aInputValue) {
+    return sBenchmarkTripleLowpass.update(aInputValue);
+}
+void resetDoubleLowpass_int32() {
+    sBenchmarkDoubleLowpass_int32.reset();
+}
+int16_t doDoubleLowpass_int32_step(int16_t aInputValue) {
+    return sBenchmarkDoubleLowpass_int32.update(aInputValue);
+}
+void resetBiquad16() {
+    initBiquad16(&sBenchmarkBiquad16, SAMPLE_FREQUENCY_HERTZ, BIQUAD_CUTOFF_HERTZ, BIQUAD_Q);
+}
+int16_t doBiquad16_step(int16_t aInputValue) {
+    doBiquad_int16(&sBenchmarkBiquad16, aInputValue);
+    return sBenchmarkBiquad16.BiQuadLowpass;
+}
+void resetBiquad32() {
+    initBiquad32(&sBenchmarkBiquad32, SAMPLE_FREQUENCY_HERTZ, BIQUAD_CUTOFF_HERTZ, BIQUAD_Q);
+}
+int16_t doBiquad32_step(int16_t aInputValue) {
+    doBiquad_int32(&sBenchmarkBiquad32, aInputValue);
+    return sBenchmarkBiquad32.BiQuadLowpass_shift8 >> 8;
+}
+
+/*
+ * 4. order Butterworth lowpass with 2 sections
+ */
+void resetButterworth() {
+    for (uint_fast8_t i = 0; i < 2; ++i) {
+        struct BiquadCoefficientsStruct tCoefficients;
+        designBiquadLowpassCoefficients(&tCoefficients, SAMPLE_FREQUENCY_HERTZ, BIQUAD_CUTOFF_HERTZ, getButterworthSectionQ(4, i));
+        memset(&sBenchmarkButterworthDF1_Q15[i], 0, sizeof(sBenchmarkButterworthDF1_Q15[i]));
+        memset(&sBenchmarkButterworthDF2T_Q15[i], 0, sizeof(sBenchmarkButterworthDF2T_Q15[i]));
+        memset(&sBenchmarkButterworthDF1_Q31[i], 0, sizeof(sBenchmarkButterworthDF1_Q31[i]));
+        memset(&sBenchmarkButterworthDF2T_Q31[i], 0, sizeof(sBenchmarkButterworthDF2T_Q31[i]));
+        quantizeBiquadCoefficientsQ14(&sBenchmarkButterworthDF1_Q15[i].Coefficients, &tCoefficients);
+        quantizeBiquadCoefficientsQ14(&sBenchmarkButterworthDF2T_Q15[i].Coefficients, &tCoefficients);
+        quantizeBiquadCoefficientsQ30(&sBenchmarkButterworthDF1_Q31[i].Coefficients, &tCoefficients);
+        quantizeBiquadCoefficientsQ30(&sBenchmarkButterworthDF2T_Q31[i].Coefficients, &tCoefficients);
+    }
+}
+int16_t doButterworthDF1_Q15_step(int16_t aInputValue) {
+    return doBiquadSOSDF1_Q15(sBenchmarkButterworthDF1_Q15, 2, aInputValue);
+}
+int16_t doButterworthDF2T_Q15_step(int16_t aInputValue) {
+    return doBiquadSOSDF2T_Q15(sBenchmarkButterworthDF2T_Q15, 2, aInputValue);
+}
+int16_t doButterworthDF1_Q31_step(int16_t aInputValue) {
+    return (doBiquadSOSDF1_Q31(sBenchmarkButterworthDF1_Q31, 2, (int32_t) aInputValue << 16) + 0x8000L) >> 16; // rounded
+}
+int16_t doButterworthDF2T_Q31_step(int16_t aInputValue) {
+    return (doBiquadSOSDF2T_Q31(sBenchmarkButterworthDF2T_Q31, 2, (int32_t) aInputValue << 16) + 0x8000L) >> 16; // rounded
+}
+void resetNotch() {
+    struct BiquadCoefficientsStruct tCoefficients;
+    designBiquadNotchCoefficients(&tCoefficients, SAMPLE_FREQUENCY_HERTZ, NOTCH_FREQUENCY_HERTZ, NOTCH_Q);
+    memset(&sBenchmarkNotch_Q15, 0, sizeof(sBenchmarkNotch_Q15));
+    quantizeBiquadCoefficientsQ14(&sBenchmarkNotch_Q15.Coefficients, &tCoefficients);
+}
+int16_t doNotch_Q15_step(int16_t aInputValue) {
+    return doBiquadDF2T_Q15(&sBenchmarkNotch_Q15, aInputValue);
+}
+void resetMovingAverage16() {
+    sBenchmarkMovingAverage16.reset();
+}
+int16_t doMovingAverage16_step(int16_t aInputValue) {
+    return sBenchmarkMovingAverage16.update(aInputValue);
+}
+void resetMedian5() {
+    sBenchmarkMedian5.reset();
+}
+int16_t doMedian5_step(int16_t aInputValue) {
+    return sBenchmarkMedian5.update(aInputValue);
+}
+void resetMedian15() {
+    sBenchmarkMedian15.reset();
+}
+int16_t doMedian15_step(int16_t aInputValue) {
+    return sBenchmarkMedian15.update(aInputValue);
+}
+
+/*
+ * Reference filter functions
+ */
+void resetReferenceLowpassShift() {
+    resetReferenceLowpassCascade(&sReferenceLowpassCascade, 1.0 / (1 << EMA_SHIFT), 1);
+}
+void resetReferenceLowpassAlpha() {
+    resetReferenceLowpassCascade(&sReferenceLowpassCascade, EMA_ALPHA_SHIFT8 / 256.0, 1);
+}
+void resetReferenceDoubleLowpass() {
+    resetReferenceLowpassCascade(&sReferenceLowpassCascade, 1.0 / (1 << EMA_SHIFT), 2);
+}
+void resetReferenceTripleLowpass() {
+    resetReferenceLowpassCascade(&sReferenceLowpassCascade, 1.0 / (1 << EMA_SHIFT), 3);
+}
+double doReferenceLowpassCascade_step(double aInputValue) {
+    return doReferenceLowpassCascade(&sReferenceLowpassCascade, aInputValue);
+}
+void resetReferenceStateVariableFilter() {
+    sReferenceStateVariableFilter.Alpha = getBiquadAlpha_shift8(SAMPLE_FREQUENCY_HERTZ, BIQUAD_CUTOFF_HERTZ) / 256.0;
+    sReferenceStateVariableFilter.DampingFactor = getBiquadDampingFactor_shift8(BIQUAD_Q) / 256.0;
+    sReferenceStateVariableFilter.Lowpass = 0;
+    sReferenceStateVariableFilter.Bandpass = 0;
+}
+double doReferenceStateVariableFilter_step(double aInputValue) {
+    return doReferenceStateVariableFilter(&sReferenceStateVariableFilter, aInputValue);
+}
+void resetReferenceButterworth() {
+    for (uint_fast8_t i = 0; i < 2; ++i) {
+        designBiquadLowpassCoefficients(&sReferenceButterworth[i].Coefficients, SAMPLE_FREQUENCY_HERTZ, BIQUAD_CUTOFF_HERTZ,
+                getButterworthSectionQ(4, i));
+        resetReferenceBiquad(&sReferenceButterworth[i]);
+    }
+}
+double doReferenceButterworth_step(double aInputValue) {
+    return doReferenceBiquad(&sReferenceButterworth[1], doReferenceBiquad(&sReferenceButterworth[0], aInputValue));
+}
+void resetReferenceNotch() {
+    designBiquadNotchCoefficients(&sReferenceNotch.Coefficients, SAMPLE_FREQUENCY_HERTZ, NOTCH_FREQUENCY_HERTZ, NOTCH_Q);
+    resetReferenceBiquad(&sReferenceNotch);
+}
+double doReferenceNotch_step(double aInputValue) {
+    return doReferenceBiquad(&sReferenceNotch, aInputValue);
+}
+void resetReferenceWindow() {
+    memset(sReferenceWindow, 0, sizeof(sReferenceWindow));
+    sReferenceWindowIndex = 0;
+}
+double doReferenceMovingAverage16_step(double aInputValue) {
+    sReferenceWindow[sReferenceWindowIndex] = aInputValue;
+    sReferenceWindowIndex = (sReferenceWindowIndex + 1) % 16;
+    double tSum = 0;
+    for (uint_fast8_t i = 0; i < 16; ++i) {
+        tSum += sReferenceWindow[i];
+    }
+    return tSum / 16;
+}
+int compareDouble(const void *aValue1Ptr, const void *aValue2Ptr) {
+    double tValue1 = *(const double*) aValue1Ptr;
+    double tValue2 = *(const double*) aValue2Ptr;
+    return (tValue1 > tValue2) - (tValue1 < tValue2);
+}
+double getReferenceMedian(double aInputValue, uint8_t aWindowSize) {
+    sReferenceWindow[sReferenceWindowIndex] = aInputValue;
+    sReferenceWindowIndex = (sReferenceWindowIndex + 1) % aWindowSize;
+    double tSortedValues[15];
+    memcpy(tSortedValues, sReferenceWindow, aWindowSize * sizeof(double));
+    qsort(tSortedValues, aWindowSize, sizeof(double), compareDouble);
+    return tSortedValues[aWindowSize / 2];
+}
+double doReferenceMedian5_step(double aInputValue) {
+    return getReferenceMedian(aInputValue, 5);
+}
+double doReferenceMedian15_step(double aInputValue) {
+    return getReferenceMedian(aInputValue, 15);
+}
+
+struct FilterUnderTestStruct sFiltersUnderTest[] = {
+/* */
+{ "LowpassShift_int16 >>3", resetLowpass_int16, doLowpassShift_int16_step, resetReferenceLowpassShift, doReferenceLowpassCascade_step },
+/* */
+{ "Lowpass_int16 32/256", resetLowpass_int16, doLowpass_int16_step, resetReferenceLowpassAlpha, doReferenceLowpassCascade_step },
+/* */
+{ "LowpassShift_int32_shift8 >>3", resetLowpass_int32_shift8, doLowpassShift_int32_shift8_step, resetReferenceLowpassShift,
+        doReferenceLowpassCascade_step },
+/* */
+{ "Lowpass_int32_shift8 32/256", resetLowpass_int32_shift8, doLowpass_int32_shift8_step, resetReferenceLowpassAlpha,
+        doReferenceLowpassCascade_step },
+/* */
+{ "Lowpass_int32_shift16 >>3", resetLowpass_int32_shift16, doLowpass_int32_shift16_step, resetReferenceLowpassShift,
+        doReferenceLowpassCascade_step },
+/* */
+{ "DoubleLowpass_int32 >>3", resetDoubleLowpass_int32, doDoubleLowpass_int32_step, resetReferenceDoubleLowpass,
+        doReferenceLowpassCascade_step },
+/* */
+{ "TripleLowpass_int16 >>3", resetTripleLowpass, doTripleLowpass_step, resetReferenceTripleLowpass, doReferenceLowpassCascade_step },
+/* */
+{ "Biquad_int16 lowpass", resetBiquad16, doBiquad16_step, resetReferenceStateVariableFilter, doReferenceStateVariableFilter_step },
+/* */
+{ "Biquad_int32 lowpass", resetBiquad32, doBiquad32_step, resetReferenceStateVariableFilter, doReferenceStateVariableFilter_step },
+/* */
+{ "Butterworth4 DF1_Q15", resetButterworth, doButterworthDF1_Q15_step, resetReferenceButterworth, doReferenceButterworth_step },
+/* */
+{ "Butterworth4 DF2T_Q15", resetButterworth, doButterworthDF2T_Q15_step, resetReferenceButterworth, doReferenceButterworth_step },
+/* */
+{ "Butterworth4 DF1_Q31", resetButterworth, doButterworthDF1_Q31_step, resetReferenceButterworth, doReferenceButterworth_step },
+/* */
+{ "Butterworth4 DF2T_Q31", resetButterworth, doButterworthDF2T_Q31_step, resetReferenceButterworth, doReferenceButterworth_step },
+/* */
+{ "Notch 50 Hz DF2T_Q15", resetNotch, doNotch_Q15_step, resetReferenceNotch, doReferenceNotch_step },
+/* */
+{ "MovingAverage16", resetMovingAverage16, doMovingAverage16_step, resetReferenceWindow, doReferenceMovingAverage16_step },
+/* */
+{ "Median5", resetMedian5, doMedian5_step, resetReferenceWindow, doReferenceMedian5_step },
+/* */
+{ "Median15", resetMedian15, doMedian15_step, resetReferenceWindow, doReferenceMedian15_step } };
+
+#define NUMBER_OF_FILTERS_UNDER_TEST (sizeof(sFiltersUnderTest) / sizeof(sFiltersUnderTest[0]))
+
+/*
+ * Signals
+ */
+int16_t sStepSignal[NUMBER_OF_SAMPLES];
+int16_t sImpulseSignal[NUMBER_OF_SAMPLES];
+int16_t sChirpSignal[NUMBER_OF_SAMPLES];
+int16_t sNoiseSignal[NUMBER_OF_SAMPLES];
+int16_t sOutputValues[NUMBER_OF_SAMPLES];
+double sReferenceOutputValues[NUMBER_OF_SAMPLES];
+
+/*
+ * Linear congruential generator, gives the same noise for each run
+ */
+uint32_t sNoiseSeed = 1;
+int16_t getNoiseValue(int16_t aAmplitude) {
+    sNoiseSeed = sNoiseSeed * 1103515245 + 12345;
+    return (int16_t) ((sNoiseSeed >> 16) % (2 * aAmplitude + 1)) - aAmplitude;
+}
+
+void generateSignals() {
+    for (uint16_t i = 0; i < NUMBER_OF_SAMPLES; ++i) {
+        sStepSignal[i] = SIGNAL_AMPLITUDE;
+        sImpulseSignal[i] = 0;
+        // Linear chirp from 0 to half of the sample frequency
+        double tTime = (double) i / SAMPLE_FREQUENCY_HERTZ;
+        double tDuration = (double) NUMBER_OF_SAMPLES / SAMPLE_FREQUENCY_HERTZ;
+        sChirpSignal[i] = lround(SIGNAL_AMPLITUDE * sin(PI * (SAMPLE_FREQUENCY_HERTZ / 2) * tTime * tTime / tDuration));
+        sNoiseSignal[i] = getNoiseValue(SIGNAL_AMPLITUDE);
+    }
+    sImpulseSignal[0] = SIGNAL_AMPLITUDE;
+}
+
+/*
+ * Runs the filter and its reference over the signal
+ */
+void runFilter(struct FilterUnderTestStruct *aFilterPtr, const int16_t *aSignal, uint16_t aNumberOfSamples) {
+    aFilterPtr->ResetFunction();
+    aFilterPtr->ResetReferenceFunction();
+    for (uint16_t i = 0; i < aNumberOfSamples; ++i) {
+        sOutputValues[i] = aFilterPtr->StepFunction(aSignal[i]);
+        sReferenceOutputValues[i] = aFilterPtr->ReferenceStepFunction(aSignal[i]);
+    }
+}
+
+/*
+ * @return Number of samples until the output first reaches aPercent of the step, or -1 if never reached
+ */
+int32_t getStepResponseSamples(uint8_t aPercent) {
+    for (uint16_t i = 0; i < NUMBER_OF_SAMPLES; ++i) {
+        if (sOutputValues[i] * 100L >= SIGNAL_AMPLITUDE * (long) aPercent) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+struct ErrorStruct {
+    double Maximum;
+    double RMS;
+};
+void getQuantizationError(struct ErrorStruct *aErrorPtr) {
+    double tSquareSum = 0;
+    aErrorPtr->Maximum = 0;
+    for (uint16_t i = 0; i < NUMBER_OF_SAMPLES; ++i) {
+        double tError = fabs(sOutputValues[i] - sReferenceOutputValues[i]);
+        if (aErrorPtr->Maximum < tError) {
+            aErrorPtr->Maximum = tError;
+        }
+        tSquareSum += tError * tError;
+    }
+    aErrorPtr->RMS = sqrt(tSquareSum / NUMBER_OF_SAMPLES);
+}
+
+/*
+ * Gain of the settled filter for a sine of aFrequencyHertz in dB
+ */
+double getAttenuation(struct FilterUnderTestStruct *aFilterPtr, double aFrequencyHertz) {
+    aFilterPtr->ResetFunction();
+    double tInputSquareSum = 0;
+    double tOutputSquareSum = 0;
+    for (uint16_t i = 0; i < ATTENUATION_SAMPLES; ++i) {
+        int16_t tInputValue = lround(SIGNAL_AMPLITUDE * sin(TWO_PI * aFrequencyHertz * i / SAMPLE_FREQUENCY_HERTZ));
+        int16_t tOutputValue = aFilterPtr->StepFunction(tInputValue);
+        if (i >= ATTENUATION_SAMPLES / 2) {
+            tInputSquareSum += (double) tInputValue * tInputValue;
+            tOutputSquareSum += (double) tOutputValue * tOutputValue;
+        }
+    }
+    if (tOutputSquareSum == 0) {
+        return -99.9;
+    }
+    return 10 * log10(tOutputSquareSum / tInputSquareSum);
+}
+
+double getNanosPerSample(struct FilterUnderTestStruct *aFilterPtr) {
+    aFilterPtr->ResetFunction();
+    struct timespec tStartTime;
+    struct timespec tEndTime;
+    volatile int16_t tOutputValue __attribute__((unused));
+    clock_gettime(CLOCK_MONOTONIC, &tStartTime);
+    for (long i = 0; i < TIMING_SAMPLES; ++i) {
+        tOutputValue = aFilterPtr->StepFunction(sNoiseSignal[i % NUMBER_OF_SAMPLES]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tEndTime);
+    return ((tEndTime.tv_sec - tStartTime.tv_sec) * 1e9 + (tEndTime.tv_nsec - tStartTime.tv_nsec)) / TIMING_SAMPLES;
+}
+
+int main(int argc, char *argv[]) {
+    double tFrequencies[MAXIMUM_NUMBER_OF_FREQUENCIES] = { 5, 20, 50, 100, 250 };
+    uint8_t tNumberOfFrequencies = 5;
+    if (argc > 1) {
+        tNumberOfFrequencies = 0;
+        for (int i = 1; i < argc && tNumberOfFrequencies < MAXIMUM_NUMBER_OF_FREQUENCIES; ++i) {
+            tFrequencies[tNumberOfFrequencies++] = atof(argv[i]);
+        }
+    }
+
+    generateSignals();
+    printf("Sample frequency %d Hz, signal amplitude %d, %d samples\n\n", SAMPLE_FREQUENCY_HERTZ, SIGNAL_AMPLITUDE,
+    NUMBER_OF_SAMPLES);
+
+    printf("%-30s %5s %5s %6s | %8s %6s | %16s | %16s | %6s\n", "Filter", "t50", "t90", "final", "imp.sum", "tail",
+            "chirp err max/rms", "noise err max/rms", "ns");
+    for (uint8_t i = 0; i < NUMBER_OF_FILTERS_UNDER_TEST; ++i) {
+        struct FilterUnderTestStruct *tFilterPtr = &sFiltersUnderTest[i];
+
+        runFilter(tFilterPtr, sStepSignal, NUMBER_OF_SAMPLES);
+        int32_t t50 = getStepResponseSamples(50);
+        int32_t t90 = getStepResponseSamples(90);
+        int16_t tFinalValue = sOutputValues[NUMBER_OF_SAMPLES - 1];
+
+        runFilter(tFilterPtr, sImpulseSignal, NUMBER_OF_SAMPLES);
+        long tImpulseSum = 0;
+        uint16_t tTailLength = 0;
+        for (uint16_t j = 0; j < NUMBER_OF_SAMPLES; ++j) {
+            tImpulseSum += sOutputValues[j];
+            if (sOutputValues[j] != 0) {
+                tTailLength = j + 1;
+            }
+        }
+
+        struct ErrorStruct tChirpError;
+        runFilter(tFilterPtr, sChirpSignal, NUMBER_OF_SAMPLES);
+        getQuantizationError(&tChirpError);
+        struct ErrorStruct tNoiseError;
+        runFilter(tFilterPtr, sNoiseSignal, NUMBER_OF_SAMPLES);
+        getQuantizationError(&tNoiseError);
+
+        printf("%-30s %5d %5d %6d | %8ld %6u | %7.1f %8.2f | %7.1f %8.2f | %6.1f\n", tFilterPtr->Name, t50, t90, tFinalValue,
+                tImpulseSum, tTailLength, tChirpError.Maximum, tChirpError.RMS, tNoiseError.Maximum, tNoiseError.RMS,
+                getNanosPerSample(tFilterPtr));
+    }
+    printf("\nt50, t90: samples to reach 50 %% and 90 %% of the step, -1 if never reached. tail: samples until impulse response stays 0.\n");
+
+    printf("\nAttenuation in dB\n%-30s", "Filter");
+    for (uint8_t j = 0; j < tNumberOfFrequencies; ++j) {
+        printf(" %7.1f Hz", tFrequencies[j]);
+    }
+    printf("\n");
+    for (uint8_t i = 0; i < NUMBER_OF_FILTERS_UNDER_TEST; ++i) {
+        printf("%-30s", sFiltersUnderTest[i].Name);
+        for (uint8_t j = 0; j < tNumberOfFrequencies; ++j) {
+            printf(" %10.1f", getAttenuation(&sFiltersUnderTest[i], tFrequencies[j]));
+        }
+        printf("\n");
+    }
+    return 0;
+}
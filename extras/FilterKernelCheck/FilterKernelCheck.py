@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+#
+#  FilterKernelCheck.py
+#
+#  Host check for the AVR assembler kernels of SimpleEMAFilters.hpp.
+#  The inline assembler of multiplyInt32ByUint8Shift8(), multiplyInt32ByInt8() and shiftRightInt32By8()
+#  is read from the source and executed by a small model of the used AVR instructions.
+#  The results are compared with the C expressions of doLowpass_int32_shift8_C(), doBiquad_int32_C()
+#  and doLowpass8_int32_shift16_C(), and multiplyInt32ByInt16Shift8() is checked with the kernel results.
+#  The clock cycles of each kernel are compared with the numbers in its comment.
+#
+#  Run on Linux with:
+#  python3 FilterKernelCheck.py [<Number of random values>]
+#  The exit code is the number of failed checks.
+#
+#  Copyright (C) 2026  Armin Joachimsmeyer
+#  Email: armin.joachimsmeyer@gmail.com
+#
+#  This file is part of Arduino-Utils https://github.com/ArminJo/Arduino-Utils.
+#
+#  Arduino-Utils is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#  See the GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+#
+
+import os
+import random
+import re
+import sys
+
+SOURCE_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src', 'SimpleEMAFilters.hpp')
+
+
+class Kernel:
+    """
+    The instructions of one inline assembler kernel and the clock cycles from its comment
+    """
+
+    def __init__(self, aSource, aSignature):
+        tStart = aSource.index(aSignature)
+        tComment = aSource[aSource.rindex('/*', 0, tStart):tStart]
+        tMatch = re.search(r'(\d+)(?: to (\d+))? clock cycles', tComment)
+        self.MinCycles = int(tMatch.group(1))
+        self.MaxCycles = int(tMatch.group(2) or tMatch.group(1))
+        tAsmStart = aSource.index('__asm__', tStart)
+        tAsmEnd = re.compile(r'\n\s*:').search(aSource, tAsmStart).start()  # first line of the operand lists
+        self.Name = aSignature
+        self.Instructions = re.findall(r'"([^"]*)"\s+"\\n\\t"', aSource[tAsmStart:tAsmEnd])
+
+
+def toBytes(aValue):
+    aValue &= 0xFFFFFFFF
+    return [(aValue >> (8 * i)) & 0xFF for i in range(4)]
+
+
+def toInt32(aValue):
+    aValue &= 0xFFFFFFFF
+    return aValue - (1 << 32) if aValue & 0x80000000 else aValue
+
+
+def fromBytes(aBytes):
+    return toInt32(sum(tByte << (8 * i) for i, tByte in enumerate(aBytes)))
+
+
+def run(aKernel, aOperands):
+    """
+    Executes the instructions with the operand bytes of %0, %1 and %2. %A0 is the low byte of operand 0.
+    @return The clock cycles used
+    """
+    tRegisters = {'r0': 0, 'r1': 0}
+    tCarry = 0
+    tCycles = 0
+
+    def location(aName):
+        tMatch = re.match(r'%([A-D])?(\d)$', aName)
+        if tMatch:
+            return aOperands[int(tMatch.group(2))], ord(tMatch.group(1) or 'A') - ord('A')
+        if aName == '__zero_reg__':
+            aName = 'r1'
+        return tRegisters, aName
+
+    def read(aName):
+        tStorage, tIndex = location(aName)
+        return tStorage[tIndex]
+
+    def write(aName, aValue):
+        tStorage, tIndex = location(aName)
+        tStorage[tIndex] = aValue & 0xFF
+
+    tLabels = {tLine[:-1]: i for i, tLine in enumerate(aKernel.Instructions) if tLine.endswith(':')}
+    tProgramCounter = 0
+    tSkipNext = False
+    while tProgramCounter < len(aKernel.Instructions):
+        tLine = aKernel.Instructions[tProgramCounter]
+        tProgramCounter += 1
+        if tLine.endswith(':'):
+            continue
+        if tSkipNext:
+            tSkipNext = False
+            tCycles += 1  # skipping a one word instruction costs one additional cycle
+            continue
+        tOpcode, _, tArguments = tLine.partition(' ')
+        tArgs = [tArgument.strip() for tArgument in tArguments.split(',')] if tArguments.strip() else []
+        tCycles += 1
+        if tOpcode == 'mul':
+            tProduct = read(tArgs[0]) * read(tArgs[1])
+            tRegisters['r0'] = tProduct & 0xFF
+            tRegisters['r1'] = tProduct >> 8
+            tCarry = (tProduct >> 15) & 1
+            tCycles += 1
+        elif tOpcode == 'mov':
+            write(tArgs[0], read(tArgs[1]))
+        elif tOpcode == 'clr':
+            write(tArgs[0], 0)
+        elif tOpcode in ('add', 'adc'):
+            tValue = read(tArgs[0]) + read(tArgs[1]) + (tCarry if tOpcode == 'adc' else 0)
+            tCarry = tValue >> 8
+            write(tArgs[0], tValue)
+        elif tOpcode in ('sub', 'sbc'):
+            tValue = read(tArgs[0]) - read(tArgs[1]) - (tCarry if tOpcode == 'sbc' else 0)
+            tCarry = 1 if tValue < 0 else 0
+            write(tArgs[0], tValue)
+        elif tOpcode == 'lsl':
+            tValue = read(tArgs[0]) << 1
+            tCarry = tValue >> 8
+            write(tArgs[0], tValue)
+        elif tOpcode in ('sbrc', 'sbrs'):
+            tBitIsSet = (read(tArgs[0]) >> int(tArgs[1])) & 1
+            tSkipNext = bool(tBitIsSet) if tOpcode == 'sbrs' else not tBitIsSet
+        elif tOpcode == 'rjmp':
+            tProgramCounter = tLabels[tArgs[0][:-1]]
+            tCycles += 1
+        else:
+            raise ValueError('Instruction ' + tOpcode + ' of ' + aKernel.Name + ' is not modeled')
+    if tRegisters['r1'] != 0:
+        raise ValueError(aKernel.Name + ' does not clear __zero_reg__')
+    return tCycles
+
+
+sNumberOfChecks = 0
+sNumberOfFailedChecks = 0
+
+
+def check(aName, aActual, aExpected):
+    global sNumberOfChecks, sNumberOfFailedChecks
+    sNumberOfChecks += 1
+    if aActual != aExpected:
+        sNumberOfFailedChecks += 1
+        if sNumberOfFailedChecks <= 20:
+            print('FAIL ' + aName + ': ' + str(aActual) + ', expected ' + str(aExpected))
+
+
+def main():
+    tNumberOfRandomValues = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+    with open(SOURCE_FILE) as tFile:
+        tSource = tFile.read()
+    tUint8Shift8 = Kernel(tSource, 'int32_t multiplyInt32ByUint8Shift8(int32_t aValue')
+    tInt8 = Kernel(tSource, 'int32_t multiplyInt32ByInt8(int32_t aValue')
+    tShiftRight8 = Kernel(tSource, 'int32_t shiftRightInt32By8(int32_t aValue')
+
+    def multiplyInt32ByUint8Shift8(aValue, aFactor, aCycles):
+        tOperands = [[0] * 4, toBytes(aValue), [aFactor]]
+        aCycles.add(run(tUint8Shift8, tOperands))
+        return fromBytes(tOperands[0])
+
+    def multiplyInt32ByInt8(aValue, aFactor, aCycles):
+        tOperands = [[0] * 4, toBytes(aValue), [aFactor & 0xFF]]
+        aCycles.add(run(tInt8, tOperands))
+        return fromBytes(tOperands[0])
+
+    def shiftRightInt32By8(aValue, aCycles):
+        tOperands = [[0] * 4, toBytes(aValue)]
+        aCycles.add(run(tShiftRight8, tOperands))
+        return fromBytes(tOperands[0])
+
+    random.seed(1)
+    tValues = [0, 1, -1, 255, 256, -256, 0x7FFF, -0x8000, 0x7F00FF00, 0x7FFFFFFF, -0x80000000]
+    tValues += [random.randint(-0x80000000, 0x7FFFFFFF) for _ in range(tNumberOfRandomValues)]
+    # Differences of (24,8) accumulators of ADC values, which is the typical range of the filters
+    tValues += [random.randint(-0x3FF00, 0x3FF00) for _ in range(tNumberOfRandomValues)]
+    tUint8Factors = [0, 1, 2, 127, 128, 255]
+    tInt8Factors = [0, 1, -1, 127, -128]
+    tInt16Factors = [0, 1, -1, 255, 256, 257, -256, 0x7FFF, -0x8000]
+
+    tCyclesUint8Shift8 = set()
+    tCyclesInt8 = set()
+    tCyclesShiftRight8 = set()
+    for tValue in tValues:
+        # The kernel computes the full 40 bit product, the C version of doLowpass_int32_shift8_C() is identical if it does not overflow
+        for tFactor in tUint8Factors + [random.randint(0, 255)]:
+            tResult = multiplyInt32ByUint8Shift8(tValue, tFactor, tCyclesUint8Shift8)
+            check('multiplyInt32ByUint8Shift8(' + str(tValue) + ', ' + str(tFactor) + ') 40 bit', tResult,
+                    toInt32((tValue * tFactor) >> 8))
+            if -0x80000000 <= tValue * tFactor <= 0x7FFFFFFF:
+                check('multiplyInt32ByUint8Shift8(' + str(tValue) + ', ' + str(tFactor) + ') C', tResult,
+                        toInt32(tValue * tFactor) >> 8)
+
+        # The lower 32 bit of the product, as computed by C
+        for tFactor in tInt8Factors + [random.randint(-128, 127)]:
+            check('multiplyInt32ByInt8(' + str(tValue) + ', ' + str(tFactor) + ')',
+                    multiplyInt32ByInt8(tValue, tFactor, tCyclesInt8), toInt32(tValue * tFactor))
+
+        # multiplyInt32ByInt16Shift8() as used by doBiquad_int32(), compared with doBiquad_int32_C() where it does not overflow
+        for tFactor in tInt16Factors + [random.randint(-0x8000, 0x7FFF)]:
+            tResult = multiplyInt32ByUint8Shift8(tValue, tFactor & 0xFF, set())
+            tFactorHighByte = tFactor >> 8
+            if tFactorHighByte != 0:
+                tResult = toInt32(tResult + multiplyInt32ByInt8(tValue, tFactorHighByte, set()))
+            if -0x80000000 <= tValue * tFactor <= 0x7FFFFFFF:
+                check('multiplyInt32ByInt16Shift8(' + str(tValue) + ', ' + str(tFactor) + ')', tResult,
+                        toInt32(tValue * tFactor) >> 8)
+
+        check('shiftRightInt32By8(' + str(tValue) + ')', shiftRightInt32By8(tValue, tCyclesShiftRight8), tValue >> 8)
+
+    for tKernel, tCycles in ((tUint8Shift8, tCyclesUint8Shift8), (tInt8, tCyclesInt8), (tShiftRight8, tCyclesShiftRight8)):
+        print(tKernel.Name + '): ' + str(len(tKernel.Instructions)) + ' instructions, ' + str(min(tCycles)) + ' to '
+                + str(max(tCycles)) + ' clock cycles')
+        check(tKernel.Name + ') minimum clock cycles', min(tCycles), tKernel.MinCycles)
+        check(tKernel.Name + ') maximum clock cycles', max(tCycles), tKernel.MaxCycles)
+
+    print(str(sNumberOfFailedChecks) + ' of ' + str(sNumberOfChecks) + ' checks failed')
+    return min(sNumberOfFailedChecks, 255)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,273 @@
+/*
+ * ADCSimulation.h
+ *
+ * Host backend for ADCUtils. It emulates the ADC registers of an ATmega328P and the few Arduino functions used by ADCUtils,
+ * so that ADCUtils can be compiled and run on Linux for tests and benchmarks.
+ * Activate it by #define USE_ADC_SIMULATION before #include "ADCUtils.hpp". Do NOT use it for AVR targets.
+ * SimpleEMAFilters.hpp uses it too, if USE_ADC_SIMULATION is defined.
+ * See extras/ADCUtilsTest for unit tests based on it.
+ *
+ * Time is simulated. Conversions take 13 ADC clocks (25 for the first one after enabling the ADC) for the selected prescaler.
+ * Busy waiting for a conversion advances the simulated time to the end of the conversion.
+ * delay() and delayMicroseconds() advance the simulated time, each call of micros() or millis() advances it by
+ * ADC_SIMULATION_MICROS_PER_TIME_CALL, so that polling loops terminate.
+ *
+ * Conversion results are taken from (in this order)
+ * 1. a source function set by setADCSimulationSourceFunction(), e.g. for waveforms
+ * 2. a script of raw values set by setADCSimulationScript()
+ * 3. a model of VCC, internal reference, temperature sensor and channel voltages in sADCSimulation
+ *
+ *  Copyright (C) 2026  Armin Joachimsmeyer
+ *  Email: armin.joachimsmeyer@gmail.com
+ *
+ *  This file is part of Arduino-Utils https://github.com/ArminJo/Arduino-Utils.
+ *
+ *  Arduino-Utils is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef _ADC_SIMULATION_H
+#define _ADC_SIMULATION_H
+
+#if defined(ARDUINO)
+#error "ADCSimulation.h is only for compiling ADCUtils on a host like Linux"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Pretend to be an Arduino Uno.
+ * !!! Every header included after this one sees a fake AVR target with __AVR__ and __AVR_ATmega328P__ defined,
+ * so it may select AVR code, which does not compile or run on the host. __AVR_ARCH__ is not defined, so inline assembler is not used.
+ */
+#if !defined(__AVR__)
+#define __AVR__
+#endif
+#if !defined(__AVR_ATmega328P__)
+#define __AVR_ATmega328P__
+#endif
+#if !defined(F_CPU)
+#define F_CPU 16000000L
+#endif
+
+#if !defined(ADC_SIMULATION_MICROS_PER_TIME_CALL)
+#define ADC_SIMULATION_MICROS_PER_TIME_CALL 4 // Simulated duration of a micros() or millis() call
+#endif
+
+/*
+ * Arduino definitions
+ */
+#define DEFAULT     1
+#define EXTERNAL    0
+#define INTERNAL    3
+#define PI          3.1415926535897932384626433832795
+#define TWO_PI      6.283185307179586476925286766559
+typedef uint8_t byte;
+#define _BV(aBit) (1 << (aBit))
+#define bit_is_set(aRegister, aBit)     ((aRegister) & _BV(aBit))
+#define bit_is_clear(aRegister, aBit)   (!((aRegister) & _BV(aBit)))
+#define loop_until_bit_is_set(aRegister, aBit)      do {} while (bit_is_clear(aRegister, aBit))
+#define loop_until_bit_is_clear(aRegister, aBit)    do {} while (bit_is_set(aRegister, aBit))
+
+#define PROGMEM
+#define EEMEM
+#define pgm_read_byte(aAddress) (*(aAddress))
+#define pgm_read_word(aAddress) (*(aAddress))
+class __FlashStringHelper;
+#define F(aString) (reinterpret_cast<const __FlashStringHelper *>(aString))
+
+#define ISR(aVector) void aVector()
+#define EMPTY_INTERRUPT(aVector) void aVector() {}
+#define ADC_vect ADCSimulationADCInterruptHandler
+void ADCSimulationADCInterruptHandler() __attribute__((weak)); // Defined by ISR(ADC_vect) of ADCUtils.hpp, if used
+#define sei()
+#define cli()
+inline void interrupts() {
+}
+inline void noInterrupts() {
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long aMillis);
+void delayMicroseconds(unsigned int aMicros);
+
+/*
+ * Minimal Print class writing to stdout
+ */
+class Print {
+public:
+    virtual ~Print() {
+    }
+    virtual size_t write(uint8_t aChar) {
+        return (putchar(aChar) == EOF) ? 0 : 1;
+    }
+    size_t write(const char *aString) {
+        size_t tLength = 0;
+        while (*aString != '\0') {
+            tLength += write((uint8_t) *aString++);
+        }
+        return tLength;
+    }
+    size_t print(const __FlashStringHelper *aString) {
+        return write(reinterpret_cast<const char*>(aString));
+    }
+    size_t print(const char *aString) {
+        return write(aString);
+    }
+    size_t print(char aChar) {
+        return write((uint8_t) aChar);
+    }
+    size_t print(long aValue) {
+        char tBuffer[24];
+        snprintf(tBuffer, sizeof(tBuffer), "%ld", aValue);
+        return write(tBuffer);
+    }
+    size_t print(unsigned long aValue) {
+        char tBuffer[24];
+        snprintf(tBuffer, sizeof(tBuffer), "%lu", aValue);
+        return write(tBuffer);
+    }
+    size_t print(int aValue) {
+        return print((long) aValue);
+    }
+    size_t print(unsigned int aValue) {
+        return print((unsigned long) aValue);
+    }
+    size_t print(unsigned char aValue) {
+        return print((unsigned long) aValue);
+    }
+    size_t print(double aValue, int aDigits = 2) {
+        char tBuffer[32];
+        snprintf(tBuffer, sizeof(tBuffer), "%.*f", aDigits, aValue);
+        return write(tBuffer);
+    }
+    template<typename T> size_t println(T aValue) {
+        size_t tLength = print(aValue);
+        return tLength + println();
+    }
+    size_t println() {
+        return write((uint8_t) '\n');
+    }
+};
+extern Print Serial;
+
+/*
+ * EEPROM is simulated by the EEMEM variables themselves. Use eraseADCSimulationEEPROM() to get the 0xFF content of an erased EEPROM.
+ */
+void eeprom_read_block(void *aDestination, const void *aSource, size_t aSize);
+void eeprom_update_block(const void *aSource, void *aDestination, size_t aSize);
+void eraseADCSimulationEEPROM(void *aEEPROMAddress, size_t aSize);
+
+/*
+ * Sleep, as used by USE_ADC_NOISE_REDUCTION_SLEEP
+ */
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN     _BV(SM1)
+#define set_sleep_mode(aMode)   (SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (aMode))
+#define sleep_enable()          (SMCR |= _BV(SE))
+#define sleep_disable()         (SMCR &= ~_BV(SE))
+void sleep_cpu();
+
+/*
+ * ADC registers and bits of the ATmega328P. Only ADCSRA has side effects.
+ */
+#define REFS1   7
+#define REFS0   6
+#define ADLAR   5
+#define MUX3    3
+#define MUX2    2
+#define MUX1    1
+#define MUX0    0
+#define ADEN    7
+#define ADSC    6
+#define ADATE   5
+#define ADIF    4
+#define ADIE    3
+#define ADPS2   2
+#define ADPS1   1
+#define ADPS0   0
+#define ACME    6
+#define ADTS2   2
+#define ADTS1   1
+#define ADTS0   0
+#define SM2     3
+#define SM1     2
+#define SM0     1
+#define SE      0
+
+class ADCSimulationADCSRARegister {
+public:
+    operator uint8_t();
+    ADCSimulationADCSRARegister& operator=(uint8_t aValue);
+    ADCSimulationADCSRARegister& operator|=(uint8_t aValue);
+    ADCSimulationADCSRARegister& operator&=(uint8_t aValue);
+    uint8_t Value;
+};
+
+extern ADCSimulationADCSRARegister sADCSimulationADCSRA;
+extern uint8_t sADCSimulationRegisters[5];
+#define ADCSRA  sADCSimulationADCSRA
+#define ADMUX   sADCSimulationRegisters[0]
+#define ADCSRB  sADCSimulationRegisters[1]
+#define ADCL    sADCSimulationRegisters[2]
+#define ADCH    sADCSimulationRegisters[3]
+#define SMCR    sADCSimulationRegisters[4]
+extern uint8_t SREG;
+
+/*
+ * Simulation control
+ */
+typedef uint16_t (*ADCSimulationSourceFunction)(uint8_t aADCChannelNumber, uint8_t aReference, unsigned long aMicros);
+
+struct ADCSimulationStruct {
+    uint64_t Nanos;                     // Simulated time
+    uint64_t ConversionEndNanos;
+    bool ConversionIsRunning;
+    bool ADCWasEnabled;                 // For 25 clocks of first conversion
+    uint16_t PendingResult;             // Value sampled at start of the running conversion
+    uint32_t NumberOfConversions;
+    bool InterruptHandlerIsRunning;     // Reading ADCSRA in the ISR is not busy waiting
+
+    /*
+     * Model used if there is no source function or script
+     */
+    uint16_t VCCMillivolt;              // DEFAULT reference
+    uint16_t AREFMillivolt;             // EXTERNAL reference
+    uint16_t InternalReferenceMillivolt;// INTERNAL reference and 1.1 volt channel
+    int16_t TemperatureCentiDegree;     // Temperature sensor channel
+    uint16_t ChannelMillivolt[8];       // ADC0 to ADC7
+    int16_t NoiseAmplitudeRaw;          // Deterministic pseudo random noise of +/- NoiseAmplitudeRaw is added
+    uint32_t NoiseSeed;
+
+    ADCSimulationSourceFunction SourceFunction;
+    const uint16_t *Script;
+    uint16_t ScriptLength;
+    uint16_t ScriptIndex;
+    bool ScriptRepeat;
+};
+extern ADCSimulationStruct sADCSimulation;
+
+void resetADCSimulation();
+void setADCSimulationSourceFunction(ADCSimulationSourceFunction aSourceFunction);
+void setADCSimulationScript(const uint16_t *aRawValues, uint16_t aNumberOfValues, bool aRepeat);
+void advanceADCSimulationMicros(unsigned long aMicros);
+uint32_t getADCSimulationConversionNanos(bool aIsFirstConversion);
+
+#endif // _ADC_SIMULATION_H
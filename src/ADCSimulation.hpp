@@ -0,0 +1,273 @@
+/*
+ * ADCSimulation.hpp
+ *
+ * Implementation of the host backend for ADCUtils. Included by ADCUtils.hpp if USE_ADC_SIMULATION is defined.
+ *
+ *  Copyright (C) 2026  Armin Joachimsmeyer
+ *  Email: armin.joachimsmeyer@gmail.com
+ *
+ *  This file is part of Arduino-Utils https://github.com/ArminJo/Arduino-Utils.
+ *
+ *  Arduino-Utils is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+ *
+ */
+
+#ifndef _ADC_SIMULATION_HPP
+#define _ADC_SIMULATION_HPP
+
+#include "ADCSimulation.h"
+
+Print Serial;
+ADCSimulationADCSRARegister sADCSimulationADCSRA;
+uint8_t sADCSimulationRegisters[5];
+uint8_t SREG;
+ADCSimulationStruct sADCSimulation;
+
+/*
+ * Sets time to 0 and the model to 5 volt VCC, 1.1 volt internal reference, 25 degree and 0 volt at all channels
+ */
+void resetADCSimulation() {
+    memset(&sADCSimulation, 0, sizeof(sADCSimulation));
+    sADCSimulation.VCCMillivolt = 5000;
+    sADCSimulation.AREFMillivolt = 5000;
+    sADCSimulation.InternalReferenceMillivolt = 1100;
+    sADCSimulation.TemperatureCentiDegree = 2500;
+    sADCSimulation.NoiseSeed = 1;
+    sADCSimulationADCSRA.Value = 0;
+    memset(sADCSimulationRegisters, 0, sizeof(sADCSimulationRegisters));
+}
+
+/*
+ * @param aSourceFunction Called at the start of each conversion. NULL switches back to script or model.
+ */
+void setADCSimulationSourceFunction(ADCSimulationSourceFunction aSourceFunction) {
+    sADCSimulation.SourceFunction = aSourceFunction;
+}
+
+/*
+ * @param aRawValues Returned in order for each conversion, regardless of channel and reference.
+ *                   If the script is exhausted and aRepeat is false, the model is used.
+ */
+void setADCSimulationScript(const uint16_t *aRawValues, uint16_t aNumberOfValues, bool aRepeat) {
+    sADCSimulation.Script = aRawValues;
+    sADCSimulation.ScriptLength = aNumberOfValues;
+    sADCSimulation.ScriptIndex = 0;
+    sADCSimulation.ScriptRepeat = aRepeat;
+}
+
+/*
+ * 13 ADC clocks for a normal conversion and 25 for the first one
+ */
+uint32_t getADCSimulationConversionNanos(bool aIsFirstConversion) {
+    uint8_t tPrescaleBits = sADCSimulationADCSRA.Value & (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0));
+    uint8_t tDivisionFactor = (tPrescaleBits == 0) ? 2 : (1 << tPrescaleBits);
+    uint32_t tADCClockNanos = (1000000000UL / (F_CPU / 1000)) * tDivisionFactor / 1000;
+    return (aIsFirstConversion ? 25 : 13) * tADCClockNanos;
+}
+
+/*
+ * Model of the ATmega328P analog inputs
+ */
+uint16_t getADCSimulationModelValue(uint8_t aADCChannelNumber, uint8_t aReference) {
+    uint16_t tReferenceMillivolt;
+    if (aReference == DEFAULT) {
+        tReferenceMillivolt = sADCSimulation.VCCMillivolt;
+    } else if (aReference == INTERNAL) {
+        tReferenceMillivolt = sADCSimulation.InternalReferenceMillivolt;
+    } else {
+        tReferenceMillivolt = sADCSimulation.AREFMillivolt;
+    }
+
+    int32_t tRawValue;
+    if (aADCChannelNumber == 8) {
+        // Temperature sensor with 1.1 volt reference: raw = 317 + 1.22 * degree, like the defaults of ADCUtils
+        int32_t tOffsetRaw_scaled = (int32_t) sADCSimulation.TemperatureCentiDegree * 122;
+        tRawValue = 317 + (tOffsetRaw_scaled + ((tOffsetRaw_scaled < 0) ? -5000 : 5000)) / 10000; // rounded for negative values too
+    } else {
+        uint16_t tInputMillivolt = 0; // channel 15 is GND
+        if (aADCChannelNumber == 14) {
+            tInputMillivolt = sADCSimulation.InternalReferenceMillivolt;
+        } else if (aADCChannelNumber < 8) {
+            tInputMillivolt = sADCSimulation.ChannelMillivolt[aADCChannelNumber];
+        }
+        tRawValue = ((uint32_t) tInputMillivolt * 1024) / tReferenceMillivolt;
+    }
+
+    if (sADCSimulation.NoiseAmplitudeRaw != 0) {
+        // Linear congruential generator, gives the same sequence for each run
+        sADCSimulation.NoiseSeed = sADCSimulation.NoiseSeed * 1103515245 + 12345;
+        tRawValue += (int32_t) ((sADCSimulation.NoiseSeed >> 16) % (2 * sADCSimulation.NoiseAmplitudeRaw + 1))
+                - sADCSimulation.NoiseAmplitudeRaw;
+    }
+    if (tRawValue < 0) {
+        tRawValue = 0;
+    } else if (tRawValue > 1023) {
+        tRawValue = 1023;
+    }
+    return tRawValue;
+}
+
+uint16_t getADCSimulationValue() {
+    uint8_t tADCChannelNumber = ADMUX & 0x0F;
+    uint8_t tReference = ADMUX >> REFS0;
+    if (sADCSimulation.SourceFunction != NULL) {
+        return sADCSimulation.SourceFunction(tADCChannelNumber, tReference, sADCSimulation.Nanos / 1000);
+    }
+    if (sADCSimulation.Script != NULL) {
+        if (sADCSimulation.ScriptIndex >= sADCSimulation.ScriptLength && sADCSimulation.ScriptRepeat) {
+            sADCSimulation.ScriptIndex = 0;
+        }
+        if (sADCSimulation.ScriptIndex < sADCSimulation.ScriptLength) {
+            return sADCSimulation.Script[sADCSimulation.ScriptIndex++];
+        }
+    }
+    return getADCSimulationModelValue(tADCChannelNumber, tReference);
+}
+
+void startADCSimulationConversion(uint64_t aStartNanos) {
+    sADCSimulation.PendingResult = getADCSimulationValue();
+    sADCSimulation.ConversionEndNanos = aStartNanos + getADCSimulationConversionNanos(!sADCSimulation.ADCWasEnabled);
+    sADCSimulation.ADCWasEnabled = true;
+    sADCSimulation.ConversionIsRunning = true;
+    sADCSimulationADCSRA.Value |= _BV(ADSC);
+}
+
+/*
+ * Stores the result, sets ADIF and starts the next conversion in free running mode. Calls the ISR if ADIE is set.
+ */
+void completeADCSimulationConversion() {
+    uint8_t tADCSRA = sADCSimulationADCSRA.Value;
+    ADCL = sADCSimulation.PendingResult & 0xFF;
+    ADCH = sADCSimulation.PendingResult >> 8;
+    sADCSimulation.NumberOfConversions++;
+    sADCSimulation.ConversionIsRunning = false;
+    tADCSRA = (tADCSRA & ~_BV(ADSC)) | _BV(ADIF);
+    sADCSimulationADCSRA.Value = tADCSRA;
+    if ((tADCSRA & _BV(ADATE)) && (ADCSRB & (_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0))) == 0) {
+        // Free running mode. Other trigger sources are not simulated.
+        startADCSimulationConversion(sADCSimulation.ConversionEndNanos);
+    }
+    if ((tADCSRA & _BV(ADIE)) && ADCSimulationADCInterruptHandler) {
+        sADCSimulationADCSRA.Value &= ~_BV(ADIF); // cleared by hardware when executing the ISR
+        sADCSimulation.InterruptHandlerIsRunning = true;
+        ADCSimulationADCInterruptHandler();
+        sADCSimulation.InterruptHandlerIsRunning = false;
+    }
+}
+
+/*
+ * Processes all conversions, which end in the given time, e.g. for the interrupt driven sampler
+ */
+void advanceADCSimulationMicros(unsigned long aMicros) {
+    uint64_t tEndNanos = sADCSimulation.Nanos + (uint64_t) aMicros * 1000;
+    while (sADCSimulation.ConversionIsRunning && sADCSimulation.ConversionEndNanos <= tEndNanos) {
+        sADCSimulation.Nanos = sADCSimulation.ConversionEndNanos;
+        completeADCSimulationConversion();
+    }
+    sADCSimulation.Nanos = tEndNanos;
+}
+
+/*
+ * Reading ADCSRA while a conversion is running and ADIF is not set, is assumed to be busy waiting,
+ * so time is advanced to the end of the conversion. Not in the ISR, which e.g. checks ADATE.
+ */
+ADCSimulationADCSRARegister::operator uint8_t() {
+    if (sADCSimulation.ConversionIsRunning && !(Value & _BV(ADIF)) && !sADCSimulation.InterruptHandlerIsRunning) {
+        sADCSimulation.Nanos = sADCSimulation.ConversionEndNanos;
+        completeADCSimulationConversion();
+    }
+    return Value;
+}
+
+/*
+ * Writing 1 to ADIF clears it, writing 1 to ADSC starts a conversion and clearing ADEN stops the ADC
+ */
+ADCSimulationADCSRARegister& ADCSimulationADCSRARegister::operator=(uint8_t aValue) {
+    uint8_t tNewValue = aValue & ~(_BV(ADIF) | _BV(ADSC));
+    if (!(aValue & _BV(ADIF))) {
+        tNewValue |= Value & _BV(ADIF);
+    }
+    if (!(aValue & _BV(ADEN))) {
+        sADCSimulation.ConversionIsRunning = false;
+        sADCSimulation.ADCWasEnabled = false;
+        Value = tNewValue;
+        return *this;
+    }
+    if (sADCSimulation.ConversionIsRunning) {
+        tNewValue |= _BV(ADSC);
+    }
+    Value = tNewValue;
+    if ((aValue & _BV(ADSC)) && !sADCSimulation.ConversionIsRunning) {
+        startADCSimulationConversion(sADCSimulation.Nanos);
+    }
+    return *this;
+}
+
+ADCSimulationADCSRARegister& ADCSimulationADCSRARegister::operator|=(uint8_t aValue) {
+    return *this = (uint8_t) (Value | aValue);
+}
+
+ADCSimulationADCSRARegister& ADCSimulationADCSRARegister::operator&=(uint8_t aValue) {
+    return *this = (uint8_t) (Value & aValue);
+}
+
+/*
+ * Time functions
+ */
+unsigned long micros() {
+    advanceADCSimulationMicros(ADC_SIMULATION_MICROS_PER_TIME_CALL);
+    return sADCSimulation.Nanos / 1000;
+}
+
+unsigned long millis() {
+    advanceADCSimulationMicros(ADC_SIMULATION_MICROS_PER_TIME_CALL);
+    return sADCSimulation.Nanos / 1000000;
+}
+
+void delay(unsigned long aMillis) {
+    advanceADCSimulationMicros(aMillis * 1000);
+}
+
+void delayMicroseconds(unsigned int aMicros) {
+    advanceADCSimulationMicros(aMicros);
+}
+
+/*
+ * Entering ADC noise reduction sleep mode with enabled ADC starts a conversion like on the real hardware.
+ * Wake up is only by the ADC interrupt.
+ */
+void sleep_cpu() {
+    if ((SMCR & _BV(SE)) && (SMCR & (_BV(SM0) | _BV(SM1) | _BV(SM2))) == SLEEP_MODE_ADC
+            && (sADCSimulationADCSRA.Value & _BV(ADEN)) && !sADCSimulation.ConversionIsRunning) {
+        startADCSimulationConversion(sADCSimulation.Nanos);
+    }
+    if (sADCSimulation.ConversionIsRunning) {
+        sADCSimulation.Nanos = sADCSimulation.ConversionEndNanos;
+        completeADCSimulationConversion();
+    }
+}
+
+void eeprom_read_block(void *aDestination, const void *aSource, size_t aSize) {
+    memcpy(aDestination, aSource, aSize);
+}
+
+void eeprom_update_block(const void *aSource, void *aDestination, size_t aSize) {
+    memcpy(aDestination, aSource, aSize);
+}
+
+void eraseADCSimulationEEPROM(void *aEEPROMAddress, size_t aSize) {
+    memset(aEEPROMAddress, 0xFF, aSize);
+}
+
+#endif // _ADC_SIMULATION_HPP
@@ -24,7 +24,11 @@
 #ifndef _ADC_UTILS_H
 #define _ADC_UTILS_H
 
+#if defined(USE_ADC_SIMULATION)
+#include "ADCSimulation.h" // Host backend, replaces Arduino.h and the AVR headers
+#else
 #include <Arduino.h>
+#endif
 
 #if defined(__AVR__) && defined(ADCSRA) && defined(ADATE) && (!defined(__AVR_ATmega4809__))
 #define ADC_UTILS_ARE_AVAILABLE
@@ -170,8 +174,33 @@
 // In contrast to e.g. powered by VIN, which results in almost perfect 5 volt supply
 #endif
 
+/*
+ * Maximum age of the VCC value used by getVoltageMillivolt(uint8_t aADCChannel) and the isVCC*() functions except isVCCUndervoltageMultipleTimes().
+ * 0 means VCC is measured at each call. Each VCC measurement requires at least 350 us for channel switching.
+ */
+#if !defined(VCC_CACHE_MAXIMUM_AGE_MILLIS)
+#define VCC_CACHE_MAXIMUM_AGE_MILLIS                    0 // E.g. 1000 to use one VCC measurement for one second
+#endif
+
+/*
+ * Settle times after switching reference and channel.
+ * All experimental values are acquired by using the ADCSwitchingTest example from this library
+ */
+#if !defined(ADC_SETTLE_MICROS_FOR_SWITCH_TO_INTERNAL_REFERENCE)
+#define ADC_SETTLE_MICROS_FOR_SWITCH_TO_INTERNAL_REFERENCE  8000 // experimental value is >= 7600 us for Nano board and 6200 for Uno board
+#endif
+#if !defined(ADC_SETTLE_MICROS_FOR_SWITCH_TO_1_1_VOLT_CHANNEL)
+#define ADC_SETTLE_MICROS_FOR_SWITCH_TO_1_1_VOLT_CHANNEL     350 // 350 was ok and 300 was too less for UltimateBatteryTester
+#endif
+#if !defined(ADC_SETTLE_MICROS_FOR_CHANNEL_SWITCH)
+#define ADC_SETTLE_MICROS_FOR_CHANNEL_SWITCH                 120 // 100 kOhm requires < 100 us, 1 MOhm requires 120 us S&H switching time
+#endif
+
 extern long sLastVCCCheckMillis;
 extern uint8_t sVCCTooLowCounter;
+extern uint16_t sVCCCacheMaximumAgeMillis;      // Initialized with VCC_CACHE_MAXIMUM_AGE_MILLIS, can be changed at runtime
+extern unsigned long sVCCVoltageMillivoltMillis; // Time of last measurement stored in sVCCVoltageMillivolt
+extern bool sVCCVoltageMillivoltIsValid;
 
 uint16_t readADCChannel();
 uint16_t readADCChannel(uint8_t aADCChannelNumber);
@@ -195,6 +224,64 @@ void setADCChannelForNextConversionAndWaitUsingInternalReference(uint8_t aADCCha
 void setADCChannelForNextConversionAndWaitUsingDefaultReference(uint8_t aADCChannelNumber);
 uint8_t checkAndWaitForReferenceAndChannelToSwitch(uint8_t aADCChannelNumber, uint8_t aReference);
 
+/*
+ * Non blocking versions of checkAndWaitForReferenceAndChannelToSwitch()
+ */
+uint16_t getADCSettleMicros(uint8_t aOldADMUX, uint8_t aADCChannelNumber, uint8_t aReference);
+uint8_t requestADCChannelAndReference(uint8_t aADCChannelNumber, uint8_t aReference);
+uint16_t getADCRemainingSettleMicros();
+bool isADCChannelAndReferenceSettled();
+void requestVCCVoltageMillivolt(void);
+void requestCPUTemperature(void);
+
+/*
+ * Non blocking stability detector for slow sensors.
+ * Reading is stable, if the difference between minimum and maximum of the last WindowSize values is <= AllowedDifference.
+ * Minimum and maximum are maintained incrementally with monotonic deques, so each sample requires constant time.
+ */
+#if !defined(ADC_STABILITY_MAX_WINDOW_SIZE)
+#define ADC_STABILITY_MAX_WINDOW_SIZE   16 // Each window entry requires 6 bytes of RAM
+#endif
+#if ADC_STABILITY_MAX_WINDOW_SIZE > 128
+#error ADC_STABILITY_MAX_WINDOW_SIZE must be <= 128
+#endif
+
+#define ADC_STABILITY_PENDING   0
+#define ADC_STABILITY_SETTLED   1
+#define ADC_STABILITY_TIMEOUT   2
+
+struct ADCMonotonicDequeStruct {
+    uint16_t Values[ADC_STABILITY_MAX_WINDOW_SIZE];
+    uint8_t SampleIndexes[ADC_STABILITY_MAX_WINDOW_SIZE]; // Sample index modulo 256 of the value, to detect values leaving the window
+    uint8_t Head;
+    uint8_t Count;
+};
+
+struct ADCStabilityDetectorStruct {
+    uint8_t ADCChannelNumber;
+    uint8_t Reference;
+    uint8_t WindowSize;
+    uint8_t AllowedDifference;
+    uint16_t SampleIntervalMicros;
+    uint32_t TimeoutMicros;         // 0 means no timeout
+    uint32_t StartMicros;
+    uint32_t LastSampleMicros;
+    uint8_t State;
+    /*
+     * Statistics
+     */
+    uint16_t NumberOfSamples;       // Samples needed to settle or until timeout
+    uint32_t SettleMicros;          // Time needed to settle or until timeout
+    uint16_t Result;                // (Minimum + Maximum) / 2 of the current window
+    ADCMonotonicDequeStruct MinimumDeque;
+    ADCMonotonicDequeStruct MaximumDeque;
+};
+
+void initADCStabilityDetector(ADCStabilityDetectorStruct *aDetector, uint8_t aADCChannelNumber, uint8_t aReference,
+        uint8_t aWindowSize, uint8_t aAllowedDifference, uint16_t aSampleIntervalMicros, uint32_t aTimeoutMicros);
+bool addADCStabilitySample(ADCStabilityDetectorStruct *aDetector, uint16_t aADCValue);
+uint8_t pollADCStabilityDetector(ADCStabilityDetectorStruct *aDetector);
+
 /*
  * readVCC*() functions store the result in sVCCVoltageMillivolt or sVCCVoltage
  */
@@ -207,14 +294,106 @@ void readVCCVoltageMillivolt(void);
 uint16_t getVCCVoltageReadingFor1_1VoltReference(void);
 uint16_t printVCCVoltageMillivolt(Print *aSerial);
 void readAndPrintVCCVoltageMillivolt(Print *aSerial);
+uint16_t getVCCVoltageMillivoltCached(void);
+bool refreshVCCVoltageMillivoltCacheIfStale(void);
+void invalidateVCCVoltageMillivoltCache(void);
 
 uint16_t getVoltageMillivolt(uint16_t aVCCVoltageMillivolt, uint8_t aADCChannelForVoltageMeasurement);
 uint16_t getVoltageMillivolt(uint8_t aADCChannelForVoltageMeasurement);
 uint16_t getVoltageMillivoltWith_1_1VoltReference(uint8_t aADCChannelForVoltageMeasurement);
+
+/*
+ * Batch conversion of multiple channels with voltage dividers, e.g. for the cells of a battery.
+ * Reference voltage is determined once and results are computed by multiply and shift.
+ * ADCVoltageChannelStruct sCells[] = { ADC_VOLTAGE_CHANNEL(0, 10, 10), ADC_VOLTAGE_CHANNEL(1, 20, 10) }; // 10k/10k and 20k/10k divider
+ * readVoltagesMillivolt(sCells, sizeof(sCells) / sizeof(ADCVoltageChannelStruct), DEFAULT);
+ */
+struct ADCVoltageChannelStruct {
+    uint8_t ADCChannelNumber;
+    uint16_t DividerRatio_shift8;   // (R_upper + R_lower) / R_lower * 256, 256 for no divider
+    uint16_t Millivolt;             // Result
+};
+#define ADC_DIVIDER_RATIO_SHIFT8(aResistorUpperKOhm, aResistorLowerKOhm) \
+    ((((aResistorUpperKOhm) + (aResistorLowerKOhm)) * 256L + ((aResistorLowerKOhm) / 2)) / (aResistorLowerKOhm))
+#define ADC_VOLTAGE_CHANNEL(aADCChannelNumber, aResistorUpperKOhm, aResistorLowerKOhm) \
+    {aADCChannelNumber, ADC_DIVIDER_RATIO_SHIFT8(aResistorUpperKOhm, aResistorLowerKOhm), 0}
+
+uint16_t readVoltagesMillivolt(ADCVoltageChannelStruct *aChannels, uint8_t aNumberOfChannels, uint8_t aReference);
 float getCPUTemperatureSimple(void);
 float getCPUTemperature(void);
 float getTemperature(void) __attribute__ ((deprecated ("Renamed to getCPUTemperature()"))); // deprecated
 
+/*
+ * Integer versions without float library, which saves around 1 kByte of program memory.
+ * For VCC use getVCCVoltageMillivolt(), getVCCVoltageMillivoltSimple() and readVCCVoltageMillivolt().
+ * Temperature = (Raw - OffsetRaw) * CentiDegreePerLSB_shift8 / 256. Raw is the 4 times oversampled value with 1.1 volt reference.
+ */
+#if defined(__AVR_ATmega328PB__)
+#define CPU_TEMPERATURE_OFFSET_RAW                  245
+#define CPU_TEMPERATURE_CENTI_DEGREE_PER_LSB_SHIFT8 25600 // 1 degree per LSB
+#elif defined(__AVR_ATtiny85__)
+#define CPU_TEMPERATURE_OFFSET_RAW                  273   // 273 and 1.1666 LSB per degree are values from the datasheet
+#define CPU_TEMPERATURE_CENTI_DEGREE_PER_LSB_SHIFT8 21944 // 256 * 100 / 1.1666
+#else
+#define CPU_TEMPERATURE_OFFSET_RAW                  317
+#define CPU_TEMPERATURE_CENTI_DEGREE_PER_LSB_SHIFT8 20984 // 256 * 100 / 1.22
+#endif
+struct CPUTemperatureCalibrationStruct {
+    int16_t OffsetRaw;
+    uint16_t CentiDegreePerLSB_shift8;
+    uint8_t Checksum; // Only used for EEPROM storage
+};
+extern CPUTemperatureCalibrationStruct sCPUTemperatureCalibration;
+
+int16_t getCPUTemperatureCentiDegreeSimple(void);
+void calibrateCPUTemperatureOffset(int16_t aActualCentiDegree);
+bool readCPUTemperatureCalibrationFromEEPROM(CPUTemperatureCalibrationStruct *aEEPROMAddress);
+void storeCPUTemperatureCalibrationToEEPROM(CPUTemperatureCalibrationStruct *aEEPROMAddress);
+
+/*
+ * Calibration of internal reference and ADC gain and offset, which can be stored in EEPROM.
+ * Activate it by #define USE_ADC_CALIBRATION before #include "ADCUtils.hpp".
+ * Then the measured internal reference voltage sADCInternalReferenceMillivolt is used instead of ADC_INTERNAL_REFERENCE_MILLIVOLT
+ * and getVoltageMillivolt*() functions apply gain and offset correction for DEFAULT and INTERNAL reference.
+ * Usage:
+ * ADCCalibrationStruct sADCCalibrationEEPROM EEMEM;
+ * if (!readADCCalibrationFromEEPROM(&sADCCalibrationEEPROM)) {
+ *     calibrateADCInternalReference(5000, getCPUTemperatureCentiDegree() / 100); // VCC measured with a multimeter
+ *     storeADCCalibrationToEEPROM(&sADCCalibrationEEPROM);
+ * }
+ */
+#if defined(USE_ADC_CALIBRATION)
+#define ADC_CALIBRATION_INDEX_DEFAULT   0
+#define ADC_CALIBRATION_INDEX_INTERNAL  1
+#define ADC_CALIBRATION_NUMBER_OF_REFERENCES    2
+#define ADC_CALIBRATION_GAIN_ONE_SHIFT14        16384
+
+struct ADCReferenceCalibrationStruct {
+    uint16_t Gain_shift14;  // 16384 is gain 1.0
+    int8_t OffsetRaw;       // Raw reading of GND
+};
+
+struct ADCCalibrationStruct {
+    uint16_t InternalReferenceMillivolt;            // Measured at CalibrationTemperatureDegree
+    int16_t InternalReferenceMicrovoltPerDegree;    // Temperature coefficient of the internal reference, 0 if not known
+    int8_t CalibrationTemperatureDegree;
+    ADCReferenceCalibrationStruct References[ADC_CALIBRATION_NUMBER_OF_REFERENCES]; // Index is ADC_CALIBRATION_INDEX_*
+    uint8_t CRC8;                                   // Only used for EEPROM storage
+};
+extern ADCCalibrationStruct sADCCalibration;
+extern uint16_t sADCInternalReferenceMillivolt;     // Temperature compensated value
+
+void setADCCalibrationDefaults(void);
+uint16_t calibrateADCInternalReference(uint16_t aVCCMillivolt, int8_t aTemperatureDegree);
+void calibrateADCReferenceOffset(uint8_t aReference);
+bool calibrateADCReferenceGain(uint8_t aReference, uint8_t aADCChannelNumber, uint16_t aInputMillivolt);
+void updateADCCalibrationForTemperature(int8_t aTemperatureDegree);
+uint16_t getCalibratedADCValue(uint16_t aADCValue, uint8_t aReference);
+uint8_t computeADCCalibrationCRC8(const uint8_t *aData, uint8_t aLength);
+bool readADCCalibrationFromEEPROM(ADCCalibrationStruct *aEEPROMAddress);
+void storeADCCalibrationToEEPROM(ADCCalibrationStruct *aEEPROMAddress);
+#endif
+
 bool isVCCUSBPowered();
 bool isVCCUSBPowered(Print *aSerial);
 bool isVCCUndervoltageMultipleTimes();
@@ -225,6 +404,340 @@ bool isVCCOvervoltage();
 bool isVCCOvervoltageSimple();  // Version using readVCCVoltageMillivoltSimple()
 bool isVCCTooHighSimple();      // Version not using readVCCVoltageMillivoltSimple()
 
+/*
+ * VCC supervision service. Call tickVCCSupervision() e.g. in ISR(WDT_vect) or a timer ISR
+ * and handleVCCSupervision() in loop(). VCC is then measured every TicksPerCheck ticks,
+ * and callbacks are called in the context of handleVCCSupervision() for each condition change.
+ * Each condition has a hysteresis of VCC_SUPERVISION_HYSTERESIS_MILLIVOLT and becomes active,
+ * if VotesRequired of the last VCC_SUPERVISION_VOTING_WINDOW measurements are within its range.
+ * Usage:
+ * ISR(WDT_vect) { tickVCCSupervision(); }
+ * void handleUndervoltage(uint8_t aCondition, bool aIsActive, uint16_t aVCCMillivolt) {...}
+ * initVCCSupervision(1); registerVCCSupervisionCallback(VCC_SUPERVISION_UNDERVOLTAGE, &handleUndervoltage);
+ * loop: handleVCCSupervision(); sleepWithWatchdog(WDTO_8S, true);
+ */
+#if !defined(VCC_SUPERVISION_HYSTERESIS_MILLIVOLT)
+#define VCC_SUPERVISION_HYSTERESIS_MILLIVOLT    100
+#endif
+#if !defined(VCC_SUPERVISION_VOTING_WINDOW)
+#define VCC_SUPERVISION_VOTING_WINDOW           5 // M of N-of-M voting. Must be <= 8
+#endif
+#if !defined(VCC_SUPERVISION_VOTES_REQUIRED)
+#define VCC_SUPERVISION_VOTES_REQUIRED          3 // N of N-of-M voting. Emergency undervoltage always requires only 1 vote.
+#endif
+#if VCC_SUPERVISION_VOTING_WINDOW > 8 || VCC_SUPERVISION_VOTES_REQUIRED > VCC_SUPERVISION_VOTING_WINDOW
+#error "VCC_SUPERVISION_VOTING_WINDOW must be <= 8 and >= VCC_SUPERVISION_VOTES_REQUIRED"
+#endif
+
+#define VCC_SUPERVISION_UNDERVOLTAGE            0
+#define VCC_SUPERVISION_EMERGENCY_UNDERVOLTAGE  1
+#define VCC_SUPERVISION_OVERVOLTAGE             2
+#define VCC_SUPERVISION_USB_POWERED             3
+#define VCC_SUPERVISION_NUMBER_OF_CONDITIONS    4
+
+typedef void (*VCCSupervisionCallbackFunction)(uint8_t aCondition, bool aIsActive, uint16_t aVCCMillivolt);
+
+struct VCCSupervisionConditionStruct {
+    uint16_t LowerMillivolt;    // Condition is active if VCC is within the range
+    uint16_t UpperMillivolt;
+    uint8_t VotesRequired;
+    uint8_t History;            // One bit per measurement, bit 0 is the latest one
+    bool IsActive;
+    VCCSupervisionCallbackFunction Callback;
+};
+
+struct VCCSupervisionStruct {
+    volatile uint8_t Ticks;     // Incremented by tickVCCSupervision()
+    uint8_t TicksPerCheck;
+    VCCSupervisionConditionStruct Conditions[VCC_SUPERVISION_NUMBER_OF_CONDITIONS];
+};
+extern VCCSupervisionStruct sVCCSupervision;
+
+void initVCCSupervision(uint8_t aTicksPerCheck);
+void registerVCCSupervisionCallback(uint8_t aCondition, VCCSupervisionCallbackFunction aCallback);
+void tickVCCSupervision();
+bool handleVCCSupervision();
+void evaluateVCCSupervision(uint16_t aVCCMillivolt);
+bool isVCCSupervisionConditionActive(uint8_t aCondition);
+
+/*
+ * Optional instrumentation of the blocking ADCUtils functions. Activate it by #define ADC_UTILS_PROFILING before #include "ADCUtils.hpp".
+ * Durations are measured with Timer1 running with prescaler 8, i.e. 0.5 us resolution at 16 MHz.
+ * Durations >= 32 ms at 16 MHz are not measured correctly because of timer overflow.
+ * !!! Timer1 is then not available for other purposes like startADCSamplerWithTimer1Trigger(), Servo or tone() !!!
+ * If there is no 16 bit Timer1 like on ATtinyX5, micros() is used.
+ */
+#if defined(ADC_UTILS_PROFILING)
+#define ADC_PROFILE_READ_CHANNEL_WITH_REFERENCE 0
+#define ADC_PROFILE_WAIT_FOR_CHANNEL_SWITCH     1
+#define ADC_PROFILE_READ_OVERSAMPLE             2
+#define ADC_PROFILE_READ_MULTI_SAMPLES          3
+#define ADC_PROFILE_READ_VCC                    4
+#define ADC_PROFILE_READ_CPU_TEMPERATURE        5
+#define ADC_PROFILE_READ_SCAN_LIST              6
+#define ADC_PROFILE_NUMBER_OF_ENTRIES           7
+
+struct ADCProfileEntryStruct {
+    uint16_t NumberOfCalls;
+    uint16_t MinimumTicks;
+    uint16_t MaximumTicks;
+    uint32_t TotalTicks;
+};
+extern ADCProfileEntryStruct sADCProfile[ADC_PROFILE_NUMBER_OF_ENTRIES];
+extern uint16_t sADCProfileReferenceSwitchCount; // Reference switches handled by requestADCChannelAndReference()
+
+void startADCProfiling();
+void resetADCProfile();
+void printADCProfile(Print *aSerial);
+#endif
+
+/*
+ * Scan list for reading multiple channels with one call.
+ * Entries with the same reference are converted together and the reference of the last scan is used first,
+ * so a list with 2 references requires only one reference switch per scan.
+ * Example:
+ * ADCScanChannelStruct sScanList[] = { ADC_SCAN_ENTRY(0, DEFAULT, 2), ADC_SCAN_ENTRY(1, INTERNAL, 0), ADC_SCAN_ENTRY(2, DEFAULT, 0) };
+ * readADCScanList(sScanList, sizeof(sScanList) / sizeof(ADCScanChannelStruct), ADC_PRESCALE32);
+ * uint16_t tValue = sScanList[0].Result;
+ */
+#if !defined(ADC_SCAN_LIST_MAX_ENTRIES)
+#define ADC_SCAN_LIST_MAX_ENTRIES   16 // Determined by the uint16_t mask for pending entries
+#endif
+#if ADC_SCAN_LIST_MAX_ENTRIES > 16
+#error "ADC_SCAN_LIST_MAX_ENTRIES must be <= 16, since the mask for pending entries is uint16_t"
+#endif
+#define ADC_SCAN_MAX_OVERSAMPLE_EXPONENT    6 // 64 samples fit in the uint16_t sum
+
+struct ADCScanChannelStruct {
+    uint8_t ADMUXValue;         // Channel and reference, precomputed by ADC_SCAN_ENTRY()
+    uint8_t OversampleExponent; // 0 to ADC_SCAN_MAX_OVERSAMPLE_EXPONENT. Larger values are clamped by readADCScanList()
+    uint16_t Result;            // Rounded average of the 2^OversampleExponent samples
+};
+#define ADC_SCAN_ENTRY(aADCChannelNumber, aReference, aOversampleExponent) \
+    {(uint8_t)((aADCChannelNumber) | ((aReference) << SHIFT_VALUE_FOR_REFERENCE)), (aOversampleExponent), 0}
+
+void readADCScanList(ADCScanChannelStruct *aScanList, uint8_t aNumberOfEntries, uint8_t aPrescale);
+
+/*
+ * Streaming statistics for AC signals like mains voltage or current clamps, without float and 64 bit arithmetic.
+ * Values are accumulated relative to ZeroLevel, so the sum of squares of 10 bit values fits in 32 bit
+ * for up to ADC_STATISTICS_MAX_NUMBER_OF_SAMPLES samples. This is the limit for a ZeroLevel of 512.
+ * Other zero levels allow less samples, e.g. 4104 for ZeroLevel 0. See MaxNumberOfSamples.
+ * If NumberOfPeriods > 0, acquisition starts at the first rising zero crossing and stops after NumberOfPeriods periods.
+ * addADCStatisticsSample() can be called in an ISR, e.g. for the samples of startADCSamplerWithTimer1Trigger().
+ * Then read the results only after addADCStatisticsSample() returned true.
+ */
+#define ADC_STATISTICS_MAX_NUMBER_OF_SAMPLES    16383 // 16383 * 512 * 512 < 2^32
+#if !defined(ADC_STATISTICS_ZERO_CROSSING_HYSTERESIS)
+#define ADC_STATISTICS_ZERO_CROSSING_HYSTERESIS 4 // A crossing is detected, if value changes from below (ZeroLevel - 4) to above (ZeroLevel + 4)
+#endif
+
+#define ADC_STATISTICS_STATE_WAIT_FOR_RISING_ZERO_CROSSING  0
+#define ADC_STATISTICS_STATE_ACQUIRING                      1
+#define ADC_STATISTICS_STATE_FINISHED                       2
+
+struct ADCStatisticsStruct {
+    uint16_t ZeroLevel;             // E.g. 512 for a signal with VCC/2 offset
+    uint8_t NumberOfPeriods;        // 0 means no synchronization to zero crossings
+    uint8_t NumberOfPeriodsAcquired;
+    uint8_t State;
+    int8_t LastSign;                // 0 at start, -1 below and +1 above hysteresis band
+    uint16_t NumberOfSamples;
+    uint16_t MaxNumberOfSamples;    // SumOfSquares cannot overflow for the maximum deviation from ZeroLevel
+    uint16_t NumberOfZeroCrossings; // Rising and falling
+    uint16_t Minimum;
+    uint16_t Maximum;
+    int32_t Sum;                    // Sum of (value - ZeroLevel)
+    uint32_t SumOfSquares;          // Sum of (value - ZeroLevel)^2
+};
+
+void initADCStatistics(ADCStatisticsStruct *aStatistics, uint16_t aZeroLevel, uint8_t aNumberOfPeriods);
+bool addADCStatisticsSample(ADCStatisticsStruct *aStatistics, uint16_t aADCValue);
+void readADCStatistics(ADCStatisticsStruct *aStatistics, uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale,
+        uint16_t aMaxNumberOfSamples);
+uint16_t getADCStatisticsMean_shift4(ADCStatisticsStruct *aStatistics);
+uint16_t getADCStatisticsRMS_shift4(ADCStatisticsStruct *aStatistics);
+uint16_t getADCStatisticsACRMS_shift4(ADCStatisticsStruct *aStatistics);
+uint16_t getADCStatisticsPeakToPeak(ADCStatisticsStruct *aStatistics);
+uint16_t getMillivoltFromADCValue_shift4(uint16_t aADCValue_shift4, uint16_t aReferenceMillivolt);
+uint16_t sqrt32(uint32_t aValue);
+
+/*
+ * Differential channels with gain, e.g. for measuring small shunt voltages without external amplifier.
+ * ATtinyX5: gain 1x or 20x, result is unipolar (0 to 1023) or bipolar (-512 to 511) if ADC_DIFFERENTIAL_FLAG_BIPOLAR is set.
+ * ATmega1280/2560: gain 1x, 10x or 200x, result is always bipolar. Bit 5 of the MUX value is written to MUX5.
+ * The reference bits including REFS2 of the ATtinyX5 are handled by SHIFT_VALUE_FOR_REFERENCE as for single ended channels.
+ * Usage:
+ * ADCDifferentialChannelStruct sShunt = ADC_DIFFERENTIAL_CHANNEL(ADC_DIFFERENTIAL_ADC0_ADC1_GAIN_20X, 20, ADC_DIFFERENTIAL_FLAG_BIPOLAR);
+ * int32_t tShuntMicrovolt = getADCDifferentialMicrovolt(&sShunt, readADCDifferentialChannelWithReference(&sShunt, INTERNAL), 1100);
+ */
+#if defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+#define ADC_DIFFERENTIAL_CHANNELS_ARE_AVAILABLE
+// Positive input first
+#define ADC_DIFFERENTIAL_ADC2_ADC2_GAIN_1X      0x04 // For offset measurement
+#define ADC_DIFFERENTIAL_ADC2_ADC2_GAIN_20X     0x05
+#define ADC_DIFFERENTIAL_ADC2_ADC3_GAIN_1X      0x06
+#define ADC_DIFFERENTIAL_ADC2_ADC3_GAIN_20X     0x07
+#define ADC_DIFFERENTIAL_ADC0_ADC0_GAIN_1X      0x08
+#define ADC_DIFFERENTIAL_ADC0_ADC0_GAIN_20X     0x09
+#define ADC_DIFFERENTIAL_ADC0_ADC1_GAIN_1X      0x0A
+#define ADC_DIFFERENTIAL_ADC0_ADC1_GAIN_20X     0x0B
+// Flags are the ADCSRB bits
+#define ADC_DIFFERENTIAL_FLAG_BIPOLAR           _BV(BIN)
+#define ADC_DIFFERENTIAL_FLAG_REVERSE_POLARITY  _BV(IPR) // Swaps positive and negative input, useful in unipolar mode
+
+#elif defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+#define ADC_DIFFERENTIAL_CHANNELS_ARE_AVAILABLE
+#define ADC_DIFFERENTIAL_ADC0_ADC0_GAIN_10X     0x08 // For offset measurement
+#define ADC_DIFFERENTIAL_ADC1_ADC0_GAIN_10X     0x09
+#define ADC_DIFFERENTIAL_ADC0_ADC0_GAIN_200X    0x0A
+#define ADC_DIFFERENTIAL_ADC1_ADC0_GAIN_200X    0x0B
+#define ADC_DIFFERENTIAL_ADC2_ADC2_GAIN_10X     0x0C
+#define ADC_DIFFERENTIAL_ADC3_ADC2_GAIN_10X     0x0D
+#define ADC_DIFFERENTIAL_ADC2_ADC2_GAIN_200X    0x0E
+#define ADC_DIFFERENTIAL_ADC3_ADC2_GAIN_200X    0x0F
+#define ADC_DIFFERENTIAL_ADC0_ADC1_GAIN_1X      0x10
+#define ADC_DIFFERENTIAL_ADC2_ADC1_GAIN_1X      0x12
+#define ADC_DIFFERENTIAL_ADC3_ADC1_GAIN_1X      0x13
+#define ADC_DIFFERENTIAL_ADC0_ADC2_GAIN_1X      0x18
+#define ADC_DIFFERENTIAL_ADC1_ADC2_GAIN_1X      0x19
+#define ADC_DIFFERENTIAL_ADC3_ADC2_GAIN_1X      0x1B
+#define ADC_DIFFERENTIAL_ADC8_ADC8_GAIN_10X     0x28 // MUX5 set
+#define ADC_DIFFERENTIAL_ADC9_ADC8_GAIN_10X     0x29
+#define ADC_DIFFERENTIAL_ADC8_ADC8_GAIN_200X    0x2A
+#define ADC_DIFFERENTIAL_ADC9_ADC8_GAIN_200X    0x2B
+#define ADC_DIFFERENTIAL_ADC10_ADC10_GAIN_10X   0x2C
+#define ADC_DIFFERENTIAL_ADC11_ADC10_GAIN_10X   0x2D
+#define ADC_DIFFERENTIAL_ADC10_ADC10_GAIN_200X  0x2E
+#define ADC_DIFFERENTIAL_ADC11_ADC10_GAIN_200X  0x2F
+#define ADC_DIFFERENTIAL_MUX5_MASK              0x20
+#define ADC_DIFFERENTIAL_FLAG_BIPOLAR           0 // Always bipolar
+#endif
+
+#if defined(ADC_DIFFERENTIAL_CHANNELS_ARE_AVAILABLE)
+struct ADCDifferentialChannelStruct {
+    uint8_t MUXValue;   // One of the ADC_DIFFERENTIAL_* values
+    uint8_t Gain;       // 1, 10, 20 or 200. Only used for getADCDifferentialMicrovolt().
+    uint8_t Flags;      // ADC_DIFFERENTIAL_FLAG_*, only used for ATtinyX5
+};
+#define ADC_DIFFERENTIAL_CHANNEL(aMUXValue, aGain, aFlags) {aMUXValue, aGain, aFlags}
+
+void setADCDifferentialChannelAndReference(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference);
+int16_t readADCDifferentialChannelWithReference(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference);
+int16_t readADCDifferentialChannelWithReferenceOversample(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference,
+        uint8_t aOversampleExponent);
+int32_t getADCDifferentialMicrovolt(const ADCDifferentialChannelStruct *aChannel, int16_t aADCValue, uint16_t aReferenceMillivolt);
+#endif
+
+/*
+ * Conversions in ADC noise reduction sleep mode. The CPU and the I/O clock are stopped during conversion.
+ * Activate it by #define USE_ADC_NOISE_REDUCTION_SLEEP before #include "ADCUtils.hpp". It then uses the ADC_vect ISR!
+ * Timer0 is stopped during sleep, so millis() and micros() do not count the conversion time.
+ * Serial output is also stopped during sleep, so call Serial.flush() before.
+ */
+#if defined(USE_ADC_NOISE_REDUCTION_SLEEP)
+#  if !defined(USE_ADC_SIMULATION)
+#include <avr/sleep.h>
+#  endif
+#  if defined(SMCR)
+#define ADC_SLEEP_CONTROL_REGISTER  SMCR
+#  else
+#define ADC_SLEEP_CONTROL_REGISTER  MCUCR
+#  endif
+#  if defined(SM2)
+#define ADC_SLEEP_CONTROL_MASK      (_BV(SE) | _BV(SM2) | _BV(SM1) | _BV(SM0))
+#  else
+#define ADC_SLEEP_CONTROL_MASK      (_BV(SE) | _BV(SM1) | _BV(SM0))
+#  endif
+uint16_t readADCChannelWithReferenceSleep(uint8_t aADCChannelNumber, uint8_t aReference);
+uint16_t readADCChannelWithReferenceOversampleSleep(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aOversampleExponent);
+#endif
+
+/*
+ * Interrupt driven free running sampler, which does not block the CPU during acquisition.
+ * Activate it by #define USE_ADC_SAMPLER before #include "ADCUtils.hpp". It then uses the ADC_vect ISR!
+ * The ISR stores the conversion results in a single producer / single consumer ring buffer,
+ * which can be read by the main loop without disabling interrupts.
+ */
+#if defined(USE_ADC_CAPTURE) && !defined(USE_ADC_SAMPLER)
+#define USE_ADC_SAMPLER // Triggered capture uses the sampler buffer and ISR
+#endif
+#if defined(USE_ADC_SAMPLER)
+#if !defined(ADC_SAMPLER_BUFFER_SIZE)
+#define ADC_SAMPLER_BUFFER_SIZE     64 // 2 bytes per entry. Must be a power of 2 and <= 128
+#endif
+#if ((ADC_SAMPLER_BUFFER_SIZE & (ADC_SAMPLER_BUFFER_SIZE - 1)) != 0) || (ADC_SAMPLER_BUFFER_SIZE > 128)
+#error "ADC_SAMPLER_BUFFER_SIZE must be a power of 2 and <= 128"
+#endif
+#define ADC_SAMPLER_BUFFER_MASK     (ADC_SAMPLER_BUFFER_SIZE - 1)
+
+extern volatile uint16_t sADCSamplerBuffer[ADC_SAMPLER_BUFFER_SIZE];
+extern volatile uint8_t sADCSamplerWriteIndex; // Only written by ISR
+extern volatile uint8_t sADCSamplerReadIndex;  // Only written by main loop
+// Number of conversions dropped, because buffer was full. Timer1 triggers missed by a blocked ADC interrupt are not counted.
+extern volatile uint16_t sADCSamplerOverrunCount;
+
+void startADCSampler(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale);
+void stopADCSampler();
+uint8_t getADCSamplerNumberOfAvailableSamples();
+bool peekADCSampler(uint16_t *aADCValuePointer);
+bool readADCSampler(uint16_t *aADCValuePointer);
+uint16_t getAndResetADCSamplerOverrunCount();
+void storeADCSamplerValue(uint16_t aADCValue);
+
+/*
+ * Timer1 compare match B as auto trigger source gives a sample rate, which is independent of ADC prescaler and interrupt latency.
+ * Timer0 is not used, since it is required for millis().
+ * Timer1 is also used by the Servo library and for tone() on some boards!
+ */
+#if defined(TCCR1B) && defined(WGM12) && defined(OCR1B) && defined(OCF1B)
+#define ADC_SAMPLER_TIMER1_TRIGGER_IS_AVAILABLE
+#define ADC_TRIGGER_SOURCE_TIMER1_COMPARE_B (_BV(ADTS2) | _BV(ADTS0))
+uint32_t startADCSamplerWithTimer1Trigger(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale,
+        uint16_t aSampleFrequencyHertz);
+void stopADCSamplerWithTimer1Trigger();
+#endif
+
+/*
+ * Triggered capture like an oscilloscope. Activate it by #define USE_ADC_CAPTURE before #include "ADCUtils.hpp".
+ * The sampler buffer is continuously overwritten until the trigger condition is met.
+ * Then PostTriggerSamples values are stored and the buffer is frozen, so it contains the pre-trigger history.
+ * Usage for capturing VCC drops. A reading of the 1.1 volt channel with VCC as reference rises when VCC drops.
+ * setADCCaptureTrigger(ADC_CAPTURE_TRIGGER_RISING, (1100L * 1024) / 4000, 0, ADC_SAMPLER_BUFFER_SIZE / 2); // Trigger below 4 volt
+ * startADCSamplerWithTimer1Trigger(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, ADC_PRESCALE32, 1000);
+ * if (isADCCaptureFrozen()) { for (uint8_t i = 0; i < ADC_SAMPLER_BUFFER_SIZE; ++i) {Serial.println(getADCCaptureValue(i));}}
+ */
+#if defined(USE_ADC_CAPTURE)
+#define ADC_CAPTURE_TRIGGER_DISABLED    0 // Normal sampler operation
+#define ADC_CAPTURE_TRIGGER_RISING      1 // Previous value < Threshold <= current value
+#define ADC_CAPTURE_TRIGGER_FALLING     2 // Previous value >= Threshold > current value
+#define ADC_CAPTURE_TRIGGER_WINDOW      3 // Value < Threshold or value > ThresholdHigh
+
+#define ADC_CAPTURE_STATE_FILLING       0 // Acquiring pre-trigger history, trigger is not yet active
+#define ADC_CAPTURE_STATE_ARMED         1
+#define ADC_CAPTURE_STATE_TRIGGERED     2 // Acquiring post-trigger samples
+#define ADC_CAPTURE_STATE_FROZEN        3 // Sampler is stopped, buffer can be read
+
+struct ADCCaptureStruct {
+    uint8_t TriggerMode;
+    uint16_t Threshold;             // For rising and falling trigger and lower limit for window trigger
+    uint16_t ThresholdHigh;         // Upper limit for window trigger
+    uint8_t PostTriggerSamples;     // Number of samples stored after the trigger sample
+    uint16_t LastValue;
+    volatile uint8_t State;
+    volatile uint8_t RemainingSamples;
+};
+extern ADCCaptureStruct sADCCapture;
+
+void setADCCaptureTrigger(uint8_t aTriggerMode, uint16_t aThreshold, uint16_t aThresholdHigh, uint8_t aPostTriggerSamples);
+void disableADCCapture();
+void storeADCCaptureValue(uint16_t aADCValue);
+bool isADCCaptureFrozen();
+uint8_t getADCCaptureTriggerIndex();
+uint16_t getADCCaptureValue(uint8_t aIndex);
+#endif // defined(USE_ADC_CAPTURE)
+#endif // defined(USE_ADC_SAMPLER)
+
 #endif //  defined(__AVR__) ...
 
 /*
@@ -238,5 +751,6 @@ uint16_t readADCChannelWithReferenceOversample(uint8_t aADCChannelNumber, uint8_
 uint16_t getVCCVoltageMillivoltSimple(void);
 float getVCCVoltage(void);
 float getCPUTemperature(void);
+int16_t getCPUTemperatureCentiDegree(void);
 
 #endif // _ADC_UTILS_H
@@ -29,6 +29,12 @@
 #if defined(ADC_UTILS_ARE_AVAILABLE) // set in ADCUtils.h, if supported architecture was detected
 #define ADC_UTILS_ARE_INCLUDED
 
+#if defined(USE_ADC_SIMULATION)
+#include "ADCSimulation.hpp"
+#else
+#include <avr/eeprom.h> // for CPU temperature calibration
+#endif
+
 // Helper macro for getting a macro definition as string
 #if !defined(STR_HELPER) && !defined(STR)
 #define STR_HELPER(x) #x
@@ -46,6 +52,12 @@
 #if !defined(ADC_INTERNAL_REFERENCE_MILLIVOLT)
 #define ADC_INTERNAL_REFERENCE_MILLIVOLT    1100 // Change to value measured at the AREF pin.
 #endif
+#if defined(USE_ADC_CALIBRATION)
+uint16_t sADCInternalReferenceMillivolt = ADC_INTERNAL_REFERENCE_MILLIVOLT; // Set by calibrateADCInternalReference() or readADCCalibrationFromEEPROM()
+#define ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL sADCInternalReferenceMillivolt
+#else
+#define ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL ADC_INTERNAL_REFERENCE_MILLIVOLT
+#endif
 
 // Union to speed up the combination of low and high bytes to a word
 // it is not optimal since the compiler still generates 2 unnecessary moves
@@ -85,6 +97,74 @@ uint16_t sVCCVoltageMillivolt; // Set by readVCCVoltageMillivoltSimple(), readVC
 long sLastVCCCheckMillis;
 uint8_t sVCCTooLowCounter = 0;
 
+// for getVCCVoltageMillivoltCached()
+uint16_t sVCCCacheMaximumAgeMillis = VCC_CACHE_MAXIMUM_AGE_MILLIS;
+unsigned long sVCCVoltageMillivoltMillis;
+bool sVCCVoltageMillivoltIsValid = false;
+
+#if defined(ADC_UTILS_PROFILING)
+#  if defined(TCNT1H)
+#define ADC_PROFILE_GET_TICKS()     TCNT1
+#define ADC_PROFILE_TICKS_PER_MICROSECOND_SHIFT8    ((F_CPU / 8) / (1000000 / 256)) // 512 at 16 MHz
+#  else
+#define ADC_PROFILE_GET_TICKS()     ((uint16_t) micros())
+#define ADC_PROFILE_TICKS_PER_MICROSECOND_SHIFT8    256
+#  endif
+ADCProfileEntryStruct sADCProfile[ADC_PROFILE_NUMBER_OF_ENTRIES];
+uint16_t sADCProfileReferenceSwitchCount;
+
+/*
+ * Records the duration from construction to destruction, so all return paths of a function are covered
+ */
+class ADCProfileScope {
+public:
+    ADCProfileScope(uint8_t aProfileIndex) {
+        ProfileIndex = aProfileIndex;
+        StartTicks = ADC_PROFILE_GET_TICKS();
+    }
+    ~ADCProfileScope() {
+        uint16_t tTicks = ADC_PROFILE_GET_TICKS() - StartTicks; // handles one timer overflow
+        ADCProfileEntryStruct *tEntry = &sADCProfile[ProfileIndex];
+        if (tEntry->NumberOfCalls < 0xFFFF) {
+            tEntry->NumberOfCalls++;
+        }
+        if (tTicks < tEntry->MinimumTicks) {
+            tEntry->MinimumTicks = tTicks;
+        }
+        if (tTicks > tEntry->MaximumTicks) {
+            tEntry->MaximumTicks = tTicks;
+        }
+        tEntry->TotalTicks += tTicks;
+    }
+    uint8_t ProfileIndex;
+    uint16_t StartTicks;
+};
+#define ADC_PROFILE_FUNCTION(aProfileIndex) ADCProfileScope tADCProfileScope(aProfileIndex)
+
+/*
+ * Sets Timer1 to normal mode with prescaler 8 and resets all entries
+ */
+void startADCProfiling() {
+#  if defined(TCNT1H)
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11); // normal mode, prescaler 8
+#  endif
+    resetADCProfile();
+}
+
+void resetADCProfile() {
+    for (uint_fast8_t i = 0; i < ADC_PROFILE_NUMBER_OF_ENTRIES; ++i) {
+        sADCProfile[i].NumberOfCalls = 0;
+        sADCProfile[i].MinimumTicks = 0xFFFF;
+        sADCProfile[i].MaximumTicks = 0;
+        sADCProfile[i].TotalTicks = 0;
+    }
+    sADCProfileReferenceSwitchCount = 0;
+}
+#else
+#define ADC_PROFILE_FUNCTION(aProfileIndex) do {} while (0)
+#endif // defined(ADC_UTILS_PROFILING)
+
 /*
  * Conversion time is defined as 0.104 milliseconds by ADC_PRESCALE in ADCUtils.h.
  * Use previous settings
@@ -130,6 +210,7 @@ uint16_t readADCChannel(uint8_t aADCChannelNumber) {
  * Conversion time is defined as 0.104 milliseconds by ADC_PRESCALE in ADCUtils.h.
  */
 uint16_t readADCChannelWithReference(uint8_t aADCChannelNumber, uint8_t aReference) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_CHANNEL_WITH_REFERENCE);
     WordUnionForADCUtils tUValue;
     ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
 
@@ -203,11 +284,15 @@ void setADCChannelForNextConversionAndWaitUsingDefaultReference(uint8_t aADCChan
 }
 
 /*
- * @return original ADMUX register content for optional later restoring values
- * All experimental values are acquired by using the ADCSwitchingTest example from this library
+ * State of the non blocking reference and channel switching
  */
-uint8_t checkAndWaitForReferenceAndChannelToSwitch(uint8_t aADCChannelNumber, uint8_t aReference) {
-    uint8_t tOldADMUX = ADMUX;
+unsigned long sADCSettleStartMicros;
+uint16_t sADCSettleMicros; // 0 if no settle time is pending
+
+/*
+ * @return the time required after switching from aOldADMUX to aADCChannelNumber and aReference
+ */
+uint16_t getADCSettleMicros(uint8_t aOldADMUX, uint8_t aADCChannelNumber, uint8_t aReference) {
     /*
      * Must wait >= 7 us if reference has to be switched from 1.1 volt/INTERNAL to VCC/DEFAULT (seen on oscilloscope)
      * This is done after the 2 ADC clock cycles required for Sample & Hold :-)
@@ -216,11 +301,10 @@ uint8_t checkAndWaitForReferenceAndChannelToSwitch(uint8_t aADCChannelNumber, ui
      * Must wait >= 200 us if channel has to be switched to 1.1 volt internal channel if S&H was at 5 Volt
      */
     uint8_t tNewReference = (aReference << SHIFT_VALUE_FOR_REFERENCE);
-    ADMUX = aADCChannelNumber | tNewReference;
 #if defined(INTERNAL2V56)
-    if ((tOldADMUX & MASK_FOR_ADC_REFERENCE) != tNewReference && (aReference == INTERNAL || aReference == INTERNAL2V56)) {
+    if ((aOldADMUX & MASK_FOR_ADC_REFERENCE) != tNewReference && (aReference == INTERNAL || aReference == INTERNAL2V56)) {
 #else
-    if ((tOldADMUX & MASK_FOR_ADC_REFERENCE) != tNewReference && aReference == INTERNAL) {
+    if ((aOldADMUX & MASK_FOR_ADC_REFERENCE) != tNewReference && aReference == INTERNAL) {
 #endif
 #if defined(LOCAL_DEBUG)
         Serial.println(F("Switch from DEFAULT to INTERNAL"));
@@ -228,20 +312,92 @@ uint8_t checkAndWaitForReferenceAndChannelToSwitch(uint8_t aADCChannelNumber, ui
         /*
          * Switch reference from DEFAULT to INTERNAL
          */
-        delayMicroseconds(8000); // experimental value is >= 7600 us for Nano board and 6200 for Uno board
-    } else if ((tOldADMUX & ADC_CHANNEL_MUX_MASK) != aADCChannelNumber) {
+        return ADC_SETTLE_MICROS_FOR_SWITCH_TO_INTERNAL_REFERENCE;
+    } else if ((aOldADMUX & ADC_CHANNEL_MUX_MASK) != aADCChannelNumber) {
         if (aADCChannelNumber == ADC_1_1_VOLT_CHANNEL_MUX) {
             /*
              * Internal 1.1 Volt channel requires  <= 200 us for Nano board
              */
-            delayMicroseconds(350); // 350 was ok and 300 was too less for UltimateBatteryTester - result was 226 instead of 225
+            return ADC_SETTLE_MICROS_FOR_SWITCH_TO_1_1_VOLT_CHANNEL;
         } else {
             /*
              * 100 kOhm requires < 100 us, 1 MOhm requires 120 us S&H switching time
              */
-            delayMicroseconds(120); // experimental value is <= 1100 us for Nano board
+            return ADC_SETTLE_MICROS_FOR_CHANNEL_SWITCH;
         }
     }
+    return 0;
+}
+
+/*
+ * Sets channel and reference and starts the settle time, but does not wait.
+ * If a previous settle time is still running, the longer one of both is used.
+ * Use isADCChannelAndReferenceSettled() to check if conversion can be started.
+ * @return original ADMUX register content for optional later restoring values
+ */
+uint8_t requestADCChannelAndReference(uint8_t aADCChannelNumber, uint8_t aReference) {
+    uint8_t tOldADMUX = ADMUX;
+    uint16_t tSettleMicros = getADCSettleMicros(tOldADMUX, aADCChannelNumber, aReference);
+    ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
+#if defined(ADC_UTILS_PROFILING)
+    if ((tOldADMUX & MASK_FOR_ADC_REFERENCE) != (aReference << SHIFT_VALUE_FOR_REFERENCE)) {
+        sADCProfileReferenceSwitchCount++;
+    }
+#endif
+    if (tSettleMicros > getADCRemainingSettleMicros()) {
+        sADCSettleStartMicros = micros();
+        sADCSettleMicros = tSettleMicros;
+    }
+    return tOldADMUX;
+}
+
+uint16_t getADCRemainingSettleMicros() {
+    if (sADCSettleMicros == 0) {
+        return 0;
+    }
+    unsigned long tElapsedMicros = micros() - sADCSettleStartMicros;
+    if (tElapsedMicros >= sADCSettleMicros) {
+        sADCSettleMicros = 0;
+        return 0;
+    }
+    return sADCSettleMicros - tElapsedMicros;
+}
+
+bool isADCChannelAndReferenceSettled() {
+    return getADCRemainingSettleMicros() == 0;
+}
+
+/*
+ * Non blocking VCC measurement.
+ * Call requestVCCVoltageMillivolt() and then readVCCVoltageMillivolt() after isADCChannelAndReferenceSettled() returned true.
+ * readVCCVoltageMillivolt() will then not wait.
+ */
+void requestVCCVoltageMillivolt(void) {
+    requestADCChannelAndReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
+}
+
+/*
+ * Non blocking temperature measurement.
+ * Call requestCPUTemperature() and then getCPUTemperature() after isADCChannelAndReferenceSettled() returned true.
+ */
+void requestCPUTemperature(void) {
+#if !defined(__AVR_ATmega1280__) && !defined(__AVR_ATmega2560__)
+    requestADCChannelAndReference(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL);
+#endif
+}
+
+/*
+ * @return original ADMUX register content for optional later restoring values
+ * All experimental values are acquired by using the ADCSwitchingTest example from this library
+ */
+uint8_t checkAndWaitForReferenceAndChannelToSwitch(uint8_t aADCChannelNumber, uint8_t aReference) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_WAIT_FOR_CHANNEL_SWITCH);
+    uint8_t tOldADMUX = requestADCChannelAndReference(aADCChannelNumber, aReference);
+    uint16_t tRemainingSettleMicros = getADCRemainingSettleMicros();
+    if (tRemainingSettleMicros > 0) {
+        delayMicroseconds(tRemainingSettleMicros);
+        sADCSettleMicros = 0;
+    }
     return tOldADMUX;
 }
 
@@ -257,6 +413,7 @@ uint16_t readADCChannelWithOversample(uint8_t aADCChannelNumber, uint8_t aOversa
  * Conversion time is defined as 0.104 milliseconds by ADC_PRESCALE in ADCUtils.h.
  */
 uint16_t readADCChannelWithReferenceOversample(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aOversampleExponent) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_OVERSAMPLE);
     uint16_t tSumValue = 0;
     ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
 
@@ -310,12 +467,71 @@ uint16_t readADCChannelWithReferenceOversampleFast(uint8_t aADCChannelNumber, ui
     return ((tSumValue + (tCount >> 1)) >> aOversampleExponent);
 }
 
+/*
+ * Selects type at compile time, since <type_traits> is not available for AVR
+ */
+template<bool Condition, typename TypeIfTrue, typename TypeIfFalse>
+struct ADCSelectType {
+    typedef TypeIfTrue Type;
+};
+template<typename TypeIfTrue, typename TypeIfFalse>
+struct ADCSelectType<false, TypeIfTrue, TypeIfFalse> {
+    typedef TypeIfFalse Type;
+};
+
+/*
+ * Oversampling and decimation according to Atmel application note AVR121.
+ * Sums up 2^Exponent samples and returns a value with 10 + Exponent/2 bits resolution, i.e. 12 bit for Exponent = 4.
+ * Resolution is only increased, if the signal has at least 1 LSB noise!
+ * The sum is accumulated in an uint16_t for Exponent <= 6 and in an uint32_t else.
+ * Since all parameters are constants, the code is not larger than readADCChannelWithReferenceOversampleFast().
+ * Usage: uint16_t tValue12Bit = readADCChannelWithReferenceOversampleDecimated<0, DEFAULT, 4, ADC_PRESCALE32>();
+ * @tparam Exponent 0 to 12. 12 gives 16 bit resolution for 4096 samples and 106 ms with ADC_PRESCALE32 at 16 MHz.
+ * @tparam Prescaler can be one of ADC_PRESCALE2, ADC_PRESCALE4, 8, 16, 32, 64, 128.
+ */
+template<uint8_t Channel, uint8_t Reference, uint8_t Exponent, uint8_t Prescaler>
+uint16_t readADCChannelWithReferenceOversampleDecimated() {
+    static_assert(Exponent <= 12, "Exponent must be <= 12, otherwise the result does not fit in 16 bit");
+    static_assert(Prescaler >= ADC_PRESCALE2 && Prescaler <= ADC_PRESCALE128, "Prescaler must be one of ADC_PRESCALE2 to ADC_PRESCALE128");
+    static_assert((F_CPU >> Prescaler) <= 1000000L, "ADC clock must not exceed 1 MHz, choose a bigger Prescaler");
+    static_assert((Channel & ~ADC_CHANNEL_MUX_MASK) == 0, "Channel does not exist for this CPU");
+    static_assert((((uint16_t) Reference << SHIFT_VALUE_FOR_REFERENCE) & ~MASK_FOR_ADC_REFERENCE) == 0,
+            "Reference does not exist for this CPU");
+
+    typedef typename ADCSelectType<(Exponent <= 6), uint16_t, uint32_t>::Type SumType; // 64 * 1023 fits in 16 bit
+    typedef typename ADCSelectType<(Exponent <= 7), uint8_t, uint16_t>::Type CountType; // 128 fits in 8 bit
+    const uint8_t tShift = Exponent - (Exponent / 2); // Decimation
+
+    SumType tSumValue = 0;
+    ADMUX = Channel | (Reference << SHIFT_VALUE_FOR_REFERENCE);
+
+    ADCSRB = 0; // Free running mode. Only active if ADATE is set to 1.
+    // ADSC-StartConversion ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag
+    ADCSRA = (_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | Prescaler);
+
+    for (CountType i = 0; i < (CountType) _BV(Exponent); i++) {
+        /*
+         * wait for free running conversion to finish.
+         * Do not wait for ADSC here, since ADSC is only low for 1 ADC Clock cycle on free running conversion.
+         */
+        loop_until_bit_is_set(ADCSRA, ADIF);
+
+        ADCSRA |= _BV(ADIF); // clear bit to enable recognizing next conversion has finished
+        // Add value
+        tSumValue += ADCL | (ADCH << 8); // using WordUnionForADCUtils does not save space here
+    }
+    ADCSRA &= ~_BV(ADATE); // Disable auto-triggering (free running mode)
+    // return rounded value
+    return ((tSumValue + (((SumType) 1 << tShift) >> 1)) >> tShift);
+}
+
 /*
  * Returns sum of all sample values
  * Conversion time is defined as 0.104 milliseconds for 16 MHz Arduino by ADC_PRESCALE (=ADC_PRESCALE128) in ADCUtils.h.
  * @ param aNumberOfSamples If > 64 an overflow may occur.
  */
 uint16_t readADCChannelMultiSamplesWithReference(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aNumberOfSamples) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_MULTI_SAMPLES);
     uint16_t tSumValue = 0;
     ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
 
@@ -348,6 +564,7 @@ uint16_t readADCChannelMultiSamplesWithReference(uint8_t aADCChannelNumber, uint
  */
 uint32_t readADCChannelMultiSamplesWithReferenceAndPrescaler(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale,
         uint16_t aNumberOfSamples) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_MULTI_SAMPLES);
     uint32_t tSumValue = 0;
     ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
 
@@ -434,171 +651,733 @@ uint16_t readADCChannelWithReferenceMax(uint8_t aADCChannelNumber, uint8_t aRefe
  * @return the maximum value during aMicrosecondsToAquire measurement.
  */
 uint16_t readADCChannelWithReferenceMaxMicros(uint8_t aADCChannelNumber, uint8_t aReference, uint16_t aMicrosecondsToAquire) {
-    uint16_t tNumberOfSamples = aMicrosecondsToAquire / 26;
+    // 13 ADC clocks per free running conversion, 26 us for 16 MHz
+    uint16_t tNumberOfSamples = aMicrosecondsToAquire / ((13L * 32L * 1000000L) / F_CPU);
     return readADCChannelWithReferenceMax(aADCChannelNumber, aReference, tNumberOfSamples);
 }
 
 /*
+ * Deque helper for ADCStabilityDetectorStruct
+ * Removes all values from back, which are not better than aADCValue, then appends aADCValue.
+ * For the minimum deque, front value is the minimum of the window, for the maximum deque it is the maximum.
+ */
+void pushADCMonotonicDeque(ADCMonotonicDequeStruct *aDeque, uint16_t aADCValue, uint8_t aSampleIndex, bool aIsMaximumDeque) {
+    while (aDeque->Count > 0) {
+        uint8_t tBackIndex = (aDeque->Head + aDeque->Count - 1) % ADC_STABILITY_MAX_WINDOW_SIZE;
+        uint16_t tBackValue = aDeque->Values[tBackIndex];
+        if ((aIsMaximumDeque && tBackValue > aADCValue) || (!aIsMaximumDeque && tBackValue < aADCValue)) {
+            break;
+        }
+        aDeque->Count--;
+    }
+    uint8_t tNewIndex = (aDeque->Head + aDeque->Count) % ADC_STABILITY_MAX_WINDOW_SIZE;
+    aDeque->Values[tNewIndex] = aADCValue;
+    aDeque->SampleIndexes[tNewIndex] = aSampleIndex;
+    aDeque->Count++;
+}
+
+/*
+ * Removes front value if it has left the window
+ */
+void expireADCMonotonicDeque(ADCMonotonicDequeStruct *aDeque, uint8_t aSampleIndex, uint8_t aWindowSize) {
+    if (aDeque->Count > 0 && (uint8_t) (aSampleIndex - aDeque->SampleIndexes[aDeque->Head]) >= aWindowSize) {
+        aDeque->Head = (aDeque->Head + 1) % ADC_STABILITY_MAX_WINDOW_SIZE;
+        aDeque->Count--;
+    }
+}
+
+/*
+ * Sets channel and reference and starts the timeout.
+ * @param aWindowSize Number of values, which must be within aAllowedDifference. Must be <= ADC_STABILITY_MAX_WINDOW_SIZE.
+ * @param aSampleIntervalMicros Minimum time between 2 samples, 0 means sample at each poll
+ * @param aTimeoutMicros 0 means no timeout
+ */
+void initADCStabilityDetector(ADCStabilityDetectorStruct *aDetector, uint8_t aADCChannelNumber, uint8_t aReference,
+        uint8_t aWindowSize, uint8_t aAllowedDifference, uint16_t aSampleIntervalMicros, uint32_t aTimeoutMicros) {
+    if (aWindowSize > ADC_STABILITY_MAX_WINDOW_SIZE) {
+        aWindowSize = ADC_STABILITY_MAX_WINDOW_SIZE;
+    } else if (aWindowSize == 0) {
+        aWindowSize = 1;
+    }
+    aDetector->ADCChannelNumber = aADCChannelNumber;
+    aDetector->Reference = aReference;
+    aDetector->WindowSize = aWindowSize;
+    aDetector->AllowedDifference = aAllowedDifference;
+    aDetector->SampleIntervalMicros = aSampleIntervalMicros;
+    aDetector->TimeoutMicros = aTimeoutMicros;
+    aDetector->State = ADC_STABILITY_PENDING;
+    aDetector->NumberOfSamples = 0;
+    aDetector->SettleMicros = 0;
+    aDetector->Result = 0;
+    aDetector->MinimumDeque.Head = 0;
+    aDetector->MinimumDeque.Count = 0;
+    aDetector->MaximumDeque.Head = 0;
+    aDetector->MaximumDeque.Count = 0;
+    requestADCChannelAndReference(aADCChannelNumber, aReference);
+    aDetector->StartMicros = micros();
+}
+
+/*
+ * Adds a value read by another function or ISR, does not check timeout.
+ * Updates Result to (Minimum + Maximum) / 2 of the current window.
+ * @return true if the last WindowSize values are within AllowedDifference
+ */
+bool addADCStabilitySample(ADCStabilityDetectorStruct *aDetector, uint16_t aADCValue) {
+    uint8_t tSampleIndex = aDetector->NumberOfSamples; // modulo 256
+    aDetector->NumberOfSamples++;
+    expireADCMonotonicDeque(&aDetector->MinimumDeque, tSampleIndex, aDetector->WindowSize);
+    expireADCMonotonicDeque(&aDetector->MaximumDeque, tSampleIndex, aDetector->WindowSize);
+    pushADCMonotonicDeque(&aDetector->MinimumDeque, aADCValue, tSampleIndex, false);
+    pushADCMonotonicDeque(&aDetector->MaximumDeque, aADCValue, tSampleIndex, true);
+
+    uint16_t tMin = aDetector->MinimumDeque.Values[aDetector->MinimumDeque.Head];
+    uint16_t tMax = aDetector->MaximumDeque.Values[aDetector->MaximumDeque.Head];
+    aDetector->Result = (tMax + tMin) / 2;
+    return (aDetector->NumberOfSamples >= aDetector->WindowSize && (tMax - tMin) <= aDetector->AllowedDifference);
+}
+
+/*
+ * Call it in loop until it returns ADC_STABILITY_SETTLED or ADC_STABILITY_TIMEOUT. Never blocks for more than 1 conversion.
+ * Channel and reference are requested at each call, so other ADC functions can be used between polls.
+ * @return ADC_STABILITY_PENDING, ADC_STABILITY_SETTLED or ADC_STABILITY_TIMEOUT. Result is in aDetector->Result.
+ */
+uint8_t pollADCStabilityDetector(ADCStabilityDetectorStruct *aDetector) {
+    if (aDetector->State != ADC_STABILITY_PENDING) {
+        return aDetector->State;
+    }
+    uint32_t tMicros = micros();
+    if (aDetector->TimeoutMicros != 0 && tMicros - aDetector->StartMicros >= aDetector->TimeoutMicros) {
+        aDetector->State = ADC_STABILITY_TIMEOUT;
+        aDetector->SettleMicros = tMicros - aDetector->StartMicros;
+        return ADC_STABILITY_TIMEOUT;
+    }
+    if (aDetector->NumberOfSamples != 0 && tMicros - aDetector->LastSampleMicros < aDetector->SampleIntervalMicros) {
+        return ADC_STABILITY_PENDING;
+    }
+    requestADCChannelAndReference(aDetector->ADCChannelNumber, aDetector->Reference);
+    if (!isADCChannelAndReferenceSettled()) {
+        return ADC_STABILITY_PENDING;
+    }
+    aDetector->LastSampleMicros = tMicros;
+    if (addADCStabilitySample(aDetector, readADCChannel())) {
+        aDetector->State = ADC_STABILITY_SETTLED;
+        aDetector->SettleMicros = micros() - aDetector->StartMicros;
+    }
+    return aDetector->State;
+}
+
+/*
+ * Blocking version using ADCStabilityDetectorStruct with a window of 4 values.
  * aMaxRetries = 255 -> try forever
  * @return (tMax + tMin) / 2
  */
 uint16_t readUntil4ConsecutiveValuesAreEqual(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aDelay,
         uint8_t aAllowedDifference, uint8_t aMaxRetries) {
-    int tValues[4]; // last value is in tValues[3]
-    int tMin;
-    int tMax;
+    ADCStabilityDetectorStruct tDetector;
+    initADCStabilityDetector(&tDetector, aADCChannelNumber, aReference, 4, aAllowedDifference, 0, 0);
 
-    /*
-     * Initialize first 4 values before checking
-     */
-    tValues[0] = readADCChannelWithReference(aADCChannelNumber, aReference);
-    for (int i = 1; i < 4; ++i) {
+    while (!addADCStabilitySample(&tDetector, readADCChannelWithReference(aADCChannelNumber, aReference))) {
+        if (aMaxRetries != 255 && tDetector.NumberOfSamples >= 4) {
+            if (aMaxRetries == 0) {
+                break;
+            }
+            aMaxRetries--;
+        }
         if (aDelay != 0) {
             delay(aDelay); // Minimum is only 3 delays!
         }
-        tValues[i] = readADCChannelWithReference(aADCChannelNumber, aReference);
     }
 
-    do {
-        /*
-         * Get min and max of the last 4 values
-         */
-        tMin = READING_FOR_AREF;
-        tMax = 0;
-        for (uint_fast8_t i = 0; i < 4; ++i) {
-            if (tValues[i] < tMin) {
-                tMin = tValues[i];
-            }
-            if (tValues[i] > tMax) {
-                tMax = tValues[i];
-            }
-        }
-        /*
-         * check for terminating condition
-         */
-        if ((tMax - tMin) <= aAllowedDifference) {
-            break;
-        } else {
-            /*
-             * Get next value
-             */
-//            Serial.print("Difference=");
-//            Serial.println(tMax - tMin);
-            // Move values to front
-            for (int i = 0; i < 3; ++i) {
-                tValues[i] = tValues[i + 1];
-            }
-            // and wait before getting next value
-            if (aDelay != 0) {
-                delay(aDelay);
-            }
-            tValues[3] = readADCChannelWithReference(aADCChannelNumber, aReference);
-        }
-        if (aMaxRetries != 255) {
-            aMaxRetries--;
-        }
-    } while (aMaxRetries > 0);
-
 #if defined(LOCAL_DEBUG)
     if(aMaxRetries == 0) {
         Serial.print(F("No 4 equal values for difference "));
         Serial.print(aAllowedDifference);
-        Serial.print(F(" found "));
-        Serial.print(tValues[0]);
-        Serial.print(' ');
-        Serial.print(tValues[1]);
-        Serial.print(' ');
-        Serial.print(tValues[2]);
-        Serial.print(' ');
-        Serial.println(tValues[3]);
+        Serial.print(F(" found. Result="));
+        Serial.println(tDetector.Result);
     } else {
-        Serial.print(aMaxRetries);
-        Serial.println(F(" retries left"));
+        Serial.print(tDetector.NumberOfSamples);
+        Serial.println(F(" samples needed"));
     }
 #endif
 
-    return (tMax + tMin) / 2;
+    return tDetector.Result;
 }
 
 /*
- * !!! Function without handling of switched reference and channel.!!!
- * Use it ONLY if you only call getVCCVoltageSimple() or getVCCVoltageMillivoltSimple() in your program.
- * !!! Resolution is only 20 millivolt !!!
- * Raw reading of 1.1 V is 225 at 5 V.
- * Raw reading of 1.1 V is 221 at 5.1 V.
- * Raw reading of 1.1 V is 214 at 5.25 V (+5 %).
- * Raw reading of 1.1 V is 204 at 5.5 V (+10 %).
+ * @return index of next pending entry >= aStartIndex with the ADMUX reference bits of aReferenceBits or aNumberOfEntries if none found
  */
-float getVCCVoltageSimple(void) {
-    // use AVCC with (optional) external capacitor at AREF pin as reference
-    float tVCC = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
-    return ((READING_FOR_AREF * 1.1 * 4) / tVCC);
+uint8_t findNextADCScanEntry(ADCScanChannelStruct *aScanList, uint8_t aNumberOfEntries, uint8_t aReferenceBits, uint8_t aStartIndex) {
+    while (aStartIndex < aNumberOfEntries && (aScanList[aStartIndex].ADMUXValue & MASK_FOR_ADC_REFERENCE) != aReferenceBits) {
+        aStartIndex++;
+    }
+    return aStartIndex;
 }
 
 /*
- * !!! Function without handling of switched reference and channel.!!!
- * Use it ONLY if you only call getVCCVoltageSimple() or getVCCVoltageMillivoltSimple() in your program.
- * !!! Resolution is only 20 millivolt !!!
+ * Converts all entries with the same reference in one free running sequence.
+ * At the end of conversion n, conversion n+1 is already running with the old ADMUX content,
+ * so the ADMUX value written now is used for conversion n+2.
+ * Therefore the first conversion is discarded and ADMUX is always written 2 conversions ahead.
+ * There is no extra S&H settling time between the channels, so the source impedances should be <= 10 kOhm.
  */
-uint16_t getVCCVoltageMillivoltSimple(void) {
-    // use AVCC with external capacitor at AREF pin as reference
-    uint16_t tVCC = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
-    return (((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT * 4) / tVCC);
+void readADCScanListGroup(ADCScanChannelStruct *aScanList, uint8_t aNumberOfEntries, uint8_t aReferenceBits, uint8_t aPrescale) {
+    uint8_t tReadIndex = findNextADCScanEntry(aScanList, aNumberOfEntries, aReferenceBits, 0);
+    uint8_t tWriteIndex = tReadIndex;
+    uint8_t tReadSamplesLeft = _BV(aScanList[tReadIndex].OversampleExponent);
+    uint8_t tWriteSamplesLeft = tReadSamplesLeft - 1; // first sample is scheduled now
+    uint16_t tSumValue = 0;
+    bool tDiscardValue = true;
+
+    uint8_t tADMUXValue = aScanList[tReadIndex].ADMUXValue;
+    checkAndWaitForReferenceAndChannelToSwitch(tADMUXValue & ADC_CHANNEL_MUX_MASK,
+            (tADMUXValue & MASK_FOR_ADC_REFERENCE) >> SHIFT_VALUE_FOR_REFERENCE);
+    ADMUX = tADMUXValue;
+
+    ADCSRB = 0; // Free running mode. Only active if ADATE is set to 1.
+    // ADSC-StartConversion ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag
+    ADCSRA = (_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | aPrescale);
+
+    while (true) {
+        /*
+         * wait for free running conversion to finish.
+         * Do not wait for ADSC here, since ADSC is only low for 1 ADC Clock cycle on free running conversion.
+         */
+        loop_until_bit_is_set(ADCSRA, ADIF);
+        ADCSRA |= _BV(ADIF); // clear bit to enable recognizing next conversion has finished
+
+        /*
+         * Preload ADMUX for the conversion after the one just started
+         */
+        if (tWriteSamplesLeft == 0) {
+            tWriteIndex = findNextADCScanEntry(aScanList, aNumberOfEntries, aReferenceBits, tWriteIndex + 1);
+            if (tWriteIndex < aNumberOfEntries) {
+                ADMUX = aScanList[tWriteIndex].ADMUXValue;
+                tWriteSamplesLeft = _BV(aScanList[tWriteIndex].OversampleExponent) - 1;
+            }
+        } else {
+            tWriteSamplesLeft--;
+        }
+
+        if (tDiscardValue) {
+            tDiscardValue = false;
+            continue;
+        }
+        tSumValue += ADCL | (ADCH << 8); // using WordUnionForADCUtils does not save space here
+        if (--tReadSamplesLeft == 0) {
+            // store rounded value
+            uint8_t tOversampleExponent = aScanList[tReadIndex].OversampleExponent;
+            aScanList[tReadIndex].Result = (tSumValue + (_BV(tOversampleExponent) >> 1)) >> tOversampleExponent;
+            tReadIndex = findNextADCScanEntry(aScanList, aNumberOfEntries, aReferenceBits, tReadIndex + 1);
+            if (tReadIndex >= aNumberOfEntries) {
+                break;
+            }
+            tSumValue = 0;
+            tReadSamplesLeft = _BV(aScanList[tReadIndex].OversampleExponent);
+        }
+    }
+    ADCSRA &= ~_BV(ADATE); // Disable auto-triggering (free running mode)
+    loop_until_bit_is_clear(ADCSRA, ADSC); // wait for the already started conversion to finish
 }
 
 /*
- * Gets the hypothetical 14 bit reading of VCC using 1.1 volt reference
- * Similar to getVCCVoltageMillivolt() * 1024 / 1100
+ * Reads all entries of the scan list and stores the rounded average in the Result field.
+ * Channel and reference for the next conversion are set while the current conversion is running.
+ * Entries are grouped by reference, starting with the current reference, to minimize the number of reference switches.
+ * The delays for reference switching are handled by checkAndWaitForReferenceAndChannelToSwitch().
+ * @param aNumberOfEntries Maximum is ADC_SCAN_LIST_MAX_ENTRIES. Entries above it are not read.
+ * @param aPrescale can be one of ADC_PRESCALE2, ADC_PRESCALE4, 8, 16, 32, 64, 128.
+ *                  ADC_PRESCALE32 is recommended for excellent linearity and fast readout of 26 microseconds
  */
-uint16_t getVCCVoltageReadingFor1_1VoltReference(void) {
-    uint16_t tVCC = waitAndReadADCChannelWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
-    /*
-     * Do not switch back ADMUX to enable checkAndWaitForReferenceAndChannelToSwitch() to work correctly for the next measurement
-     */
-    return (((uint32_t)READING_FOR_AREF * READING_FOR_AREF) / tVCC);
+void readADCScanList(ADCScanChannelStruct *aScanList, uint8_t aNumberOfEntries, uint8_t aPrescale) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_SCAN_LIST);
+    if (aNumberOfEntries > ADC_SCAN_LIST_MAX_ENTRIES) {
+        aNumberOfEntries = ADC_SCAN_LIST_MAX_ENTRIES;
+    }
+    uint16_t tPendingReferencesMask = 0; // Bit is set for each entry with a reference not yet converted
+    for (uint_fast8_t i = 0; i < aNumberOfEntries; ++i) {
+        tPendingReferencesMask |= (1U << i);
+        if (aScanList[i].OversampleExponent > ADC_SCAN_MAX_OVERSAMPLE_EXPONENT) {
+            // Larger values overflow the uint8_t sample counters and the uint16_t sum of readADCScanListGroup()
+            aScanList[i].OversampleExponent = ADC_SCAN_MAX_OVERSAMPLE_EXPONENT;
+        }
+    }
+
+    uint8_t tReferenceBits = ADMUX & MASK_FOR_ADC_REFERENCE;
+    while (tPendingReferencesMask != 0) {
+        /*
+         * Use current reference if still pending, else take reference of first pending entry
+         */
+        uint8_t tFirstPendingIndex = aNumberOfEntries;
+        bool tReferenceIsPending = false;
+        for (uint_fast8_t i = 0; i < aNumberOfEntries; ++i) {
+            if (tPendingReferencesMask & (1U << i)) {
+                if (tFirstPendingIndex == aNumberOfEntries) {
+                    tFirstPendingIndex = i;
+                }
+                if ((aScanList[i].ADMUXValue & MASK_FOR_ADC_REFERENCE) == tReferenceBits) {
+                    tReferenceIsPending = true;
+                }
+            }
+        }
+        if (!tReferenceIsPending) {
+            tReferenceBits = aScanList[tFirstPendingIndex].ADMUXValue & MASK_FOR_ADC_REFERENCE;
+        }
+        readADCScanListGroup(aScanList, aNumberOfEntries, tReferenceBits, aPrescale);
+
+        for (uint_fast8_t i = 0; i < aNumberOfEntries; ++i) {
+            if ((aScanList[i].ADMUXValue & MASK_FOR_ADC_REFERENCE) == tReferenceBits) {
+                tPendingReferencesMask &= ~(1U << i);
+            }
+        }
+    }
 }
 
 /*
- * !!! Resolution is only 20 millivolt !!!
+ * @param aNumberOfPeriods 0 means no synchronization. Acquisition then starts immediately and ends at MaxNumberOfSamples.
  */
-float getVCCVoltage(void) {
-    return (getVCCVoltageMillivolt() / 1000.0);
+void initADCStatistics(ADCStatisticsStruct *aStatistics, uint16_t aZeroLevel, uint8_t aNumberOfPeriods) {
+    aStatistics->ZeroLevel = aZeroLevel;
+    /*
+     * Limit the number of samples, so that SumOfSquares cannot overflow for the maximum deviation
+     */
+    uint32_t tMaxDeviation = aZeroLevel;
+    if (aZeroLevel < MAX_ADC_VALUE - aZeroLevel) {
+        tMaxDeviation = MAX_ADC_VALUE - aZeroLevel;
+    }
+    uint32_t tMaxNumberOfSamples = 0xFFFFFFFF / (tMaxDeviation * tMaxDeviation);
+    if (tMaxNumberOfSamples > ADC_STATISTICS_MAX_NUMBER_OF_SAMPLES) {
+        tMaxNumberOfSamples = ADC_STATISTICS_MAX_NUMBER_OF_SAMPLES;
+    }
+    aStatistics->MaxNumberOfSamples = tMaxNumberOfSamples;
+    aStatistics->NumberOfPeriods = aNumberOfPeriods;
+    aStatistics->NumberOfPeriodsAcquired = 0;
+    if (aNumberOfPeriods == 0) {
+        aStatistics->State = ADC_STATISTICS_STATE_ACQUIRING;
+    } else {
+        aStatistics->State = ADC_STATISTICS_STATE_WAIT_FOR_RISING_ZERO_CROSSING;
+    }
+    aStatistics->LastSign = 0;
+    aStatistics->NumberOfSamples = 0;
+    aStatistics->NumberOfZeroCrossings = 0;
+    aStatistics->Minimum = MAX_ADC_VALUE;
+    aStatistics->Maximum = 0;
+    aStatistics->Sum = 0;
+    aStatistics->SumOfSquares = 0;
 }
 
 /*
- * Read value of 1.1 volt internal channel using VCC (DEFAULT) as reference.
- * Handles reference and channel switching by introducing the appropriate delays.
- * !!! Resolution is only 20 millivolt !!!
- * Raw reading of 1.1 V is 225 at 5 V.
- * Raw reading of 1.1 V is 221 at 5.1 V.
- * Raw reading of 1.1 V is 214 at 5.25 V (+5 %).
- * Raw reading of 1.1 V is 204 at 5.5 V (+10 %).
+ * Requires around 10 us at 16 MHz, so it can be called for each sample at 10 kHz sample rate.
+ * @return true if acquisition is finished, i.e. NumberOfPeriods are acquired or MaxNumberOfSamples is reached
  */
-uint16_t getVCCVoltageMillivolt(void) {
-    uint16_t tVCC = waitAndReadADCChannelWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
+bool addADCStatisticsSample(ADCStatisticsStruct *aStatistics, uint16_t aADCValue) {
+    if (aStatistics->State == ADC_STATISTICS_STATE_FINISHED) {
+        return true;
+    }
+    int16_t tValue = aADCValue - aStatistics->ZeroLevel;
+
     /*
-     * Do not switch back ADMUX to enable checkAndWaitForReferenceAndChannelToSwitch() to work correctly for the next measurement
+     * Zero crossing detection with hysteresis
      */
-    return (((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT) / tVCC);
+    bool tIsRisingZeroCrossing = false;
+    if (tValue > ADC_STATISTICS_ZERO_CROSSING_HYSTERESIS) {
+        if (aStatistics->LastSign < 0) {
+            tIsRisingZeroCrossing = true;
+            aStatistics->NumberOfZeroCrossings++;
+        }
+        aStatistics->LastSign = 1;
+    } else if (tValue < -ADC_STATISTICS_ZERO_CROSSING_HYSTERESIS) {
+        if (aStatistics->LastSign > 0) {
+            aStatistics->NumberOfZeroCrossings++;
+        }
+        aStatistics->LastSign = -1;
+    }
+
+    if (aStatistics->NumberOfPeriods != 0 && tIsRisingZeroCrossing) {
+        if (aStatistics->State == ADC_STATISTICS_STATE_WAIT_FOR_RISING_ZERO_CROSSING) {
+            // Start acquisition with this sample
+            aStatistics->State = ADC_STATISTICS_STATE_ACQUIRING;
+            aStatistics->NumberOfZeroCrossings = 0;
+        } else if (++aStatistics->NumberOfPeriodsAcquired >= aStatistics->NumberOfPeriods) {
+            // This sample belongs to the next period
+            aStatistics->State = ADC_STATISTICS_STATE_FINISHED;
+            return true;
+        }
+    }
+    if (aStatistics->State != ADC_STATISTICS_STATE_ACQUIRING) {
+        return false;
+    }
+
+    aStatistics->Sum += tValue;
+    aStatistics->SumOfSquares += (uint32_t) ((int32_t) tValue * tValue);
+    if (aADCValue < aStatistics->Minimum) {
+        aStatistics->Minimum = aADCValue;
+    }
+    if (aADCValue > aStatistics->Maximum) {
+        aStatistics->Maximum = aADCValue;
+    }
+    if (++aStatistics->NumberOfSamples >= aStatistics->MaxNumberOfSamples) {
+        aStatistics->State = ADC_STATISTICS_STATE_FINISHED;
+        return true;
+    }
+    return false;
 }
 
 /*
- * Does not set sVCCVoltageMillivolt
+ * Acquires samples in free running mode until statistics are finished or aMaxNumberOfSamples are read.
+ * Call initADCStatistics() before.
+ * E.g. ADC_PRESCALE128 gives 9615 samples per second at 16 MHz, which is 192 samples per 50 Hz period.
+ * @param aMaxNumberOfSamples Timeout, if no zero crossings are detected.
  */
-uint16_t printVCCVoltageMillivolt(Print *aSerial) {
-    aSerial->print(F("VCC="));
-    uint16_t tVCCVoltageMillivolt = getVCCVoltageMillivolt();
-    aSerial->print(tVCCVoltageMillivolt);
-    aSerial->println(" mV");
-    return tVCCVoltageMillivolt;
-}
+void readADCStatistics(ADCStatisticsStruct *aStatistics, uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale,
+        uint16_t aMaxNumberOfSamples) {
+    ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
 
-void readAndPrintVCCVoltageMillivolt(Print *aSerial) {
+    ADCSRB = 0; // Free running mode. Only active if ADATE is set to 1.
+    // ADSC-StartConversion ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag
+    ADCSRA = (_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | aPrescale);
+
+    for (uint16_t i = 0; i < aMaxNumberOfSamples; i++) {
+        /*
+         * wait for free running conversion to finish.
+         * Do not wait for ADSC here, since ADSC is only low for 1 ADC Clock cycle on free running conversion.
+         */
+        loop_until_bit_is_set(ADCSRA, ADIF);
+
+        ADCSRA |= _BV(ADIF); // clear bit to enable recognizing next conversion has finished
+        if (addADCStatisticsSample(aStatistics, ADCL | (ADCH << 8))) {
+            break;
+        }
+    }
+    ADCSRA &= ~_BV(ADATE); // Disable auto-triggering (free running mode)
+}
+
+/*
+ * Integer square root, bit by bit method. Requires around 100 us at 16 MHz.
+ */
+uint16_t sqrt32(uint32_t aValue) {
+    uint32_t tResult = 0;
+    uint32_t tBit = 1UL << 30; // The highest power of 4 <= 2^32
+    while (tBit > aValue) {
+        tBit >>= 2;
+    }
+    while (tBit != 0) {
+        if (aValue >= tResult + tBit) {
+            aValue -= tResult + tBit;
+            tResult = (tResult >> 1) + tBit;
+        } else {
+            tResult >>= 1;
+        }
+        tBit >>= 2;
+    }
+    return tResult;
+}
+
+/*
+ * @return mean ADC value * 16, e.g. 8200 for 512.5
+ */
+uint16_t getADCStatisticsMean_shift4(ADCStatisticsStruct *aStatistics) {
+    if (aStatistics->NumberOfSamples == 0) {
+        return 0;
+    }
+    int32_t tMeanRelative_shift4 = (aStatistics->Sum * 16) / (int32_t) aStatistics->NumberOfSamples;
+    return (aStatistics->ZeroLevel * 16) + tMeanRelative_shift4;
+}
+
+/*
+ * @return RMS of (value - ZeroLevel) * 16, including the DC part
+ */
+uint16_t getADCStatisticsRMS_shift4(ADCStatisticsStruct *aStatistics) {
+    if (aStatistics->NumberOfSamples == 0) {
+        return 0;
+    }
+    uint16_t tNumberOfSamples = aStatistics->NumberOfSamples;
+    // (SumOfSquares * 256) / NumberOfSamples without overflow
+    uint32_t tMeanOfSquares_shift8 = ((aStatistics->SumOfSquares / tNumberOfSamples) << 8)
+            + (((aStatistics->SumOfSquares % tNumberOfSamples) << 8) / tNumberOfSamples);
+    return sqrt32(tMeanOfSquares_shift8);
+}
+
+/*
+ * @return RMS of the AC part * 16, i.e. standard deviation. For a sine this is Vpp / (2 * sqrt(2)).
+ */
+uint16_t getADCStatisticsACRMS_shift4(ADCStatisticsStruct *aStatistics) {
+    if (aStatistics->NumberOfSamples == 0) {
+        return 0;
+    }
+    uint16_t tNumberOfSamples = aStatistics->NumberOfSamples;
+    uint32_t tMeanOfSquares_shift8 = ((aStatistics->SumOfSquares / tNumberOfSamples) << 8)
+            + (((aStatistics->SumOfSquares % tNumberOfSamples) << 8) / tNumberOfSamples);
+    int32_t tMean_shift4 = (aStatistics->Sum * 16) / (int32_t) tNumberOfSamples;
+    uint32_t tSquareOfMean_shift8 = tMean_shift4 * tMean_shift4;
+    if (tSquareOfMean_shift8 >= tMeanOfSquares_shift8) {
+        return 0; // can happen by rounding
+    }
+    return sqrt32(tMeanOfSquares_shift8 - tSquareOfMean_shift8);
+}
+
+uint16_t getADCStatisticsPeakToPeak(ADCStatisticsStruct *aStatistics) {
+    if (aStatistics->NumberOfSamples == 0) {
+        return 0;
+    }
+    return aStatistics->Maximum - aStatistics->Minimum;
+}
+
+/*
+ * E.g. getMillivoltFromADCValue_shift4(getADCStatisticsACRMS_shift4(&sStatistics), sVCCVoltageMillivolt)
+ */
+uint16_t getMillivoltFromADCValue_shift4(uint16_t aADCValue_shift4, uint16_t aReferenceMillivolt) {
+    return ((uint32_t) aADCValue_shift4 * aReferenceMillivolt) / (READING_FOR_AREF * 16L);
+}
+
+#if defined(ADC_DIFFERENTIAL_CHANNELS_ARE_AVAILABLE)
+/*
+ * MUX changes, which are not visible in ADMUX, require the same settle time as a channel switch
+ */
+void startADCSettleForChannelSwitch() {
+    if (ADC_SETTLE_MICROS_FOR_CHANNEL_SWITCH > getADCRemainingSettleMicros()) {
+        sADCSettleStartMicros = micros();
+        sADCSettleMicros = ADC_SETTLE_MICROS_FOR_CHANNEL_SWITCH;
+    }
+}
+
+/*
+ * @return ADCSRB value for MUX5 or BIN and IPR bits
+ */
+uint8_t getADCSRBForDifferentialChannel(const ADCDifferentialChannelStruct *aChannel) {
+#if defined(ADC_DIFFERENTIAL_MUX5_MASK)
+    if (aChannel->MUXValue & ADC_DIFFERENTIAL_MUX5_MASK) {
+        return _BV(MUX5);
+    }
+    return 0;
+#else
+    return aChannel->Flags;
+#endif
+}
+
+/*
+ * Sets ADMUX and ADCSRB and waits for channel and reference to settle.
+ * ADCSRB is written, so free running mode is selected as auto trigger source.
+ */
+void setADCDifferentialChannelAndReference(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference) {
+    uint8_t tADCSRB = getADCSRBForDifferentialChannel(aChannel);
+    if (ADCSRB != tADCSRB) {
+        ADCSRB = tADCSRB;
+        startADCSettleForChannelSwitch();
+    }
+    checkAndWaitForReferenceAndChannelToSwitch(aChannel->MUXValue & ADC_CHANNEL_MUX_MASK, aReference);
+}
+
+/*
+ * Converts the bipolar 10 bit two's complement result to int16_t
+ */
+int16_t getADCDifferentialValue(const ADCDifferentialChannelStruct *aChannel, uint16_t aADCValue) {
+#if defined(ADC_DIFFERENTIAL_MUX5_MASK)
+    (void) aChannel;
+#else
+    if (!(aChannel->Flags & ADC_DIFFERENTIAL_FLAG_BIPOLAR)) {
+        return aADCValue;
+    }
+#endif
+    return ((int16_t) (aADCValue << 6)) >> 6; // sign extension of bit 9
+}
+
+/*
+ * Restores single ended operation for the other functions, which do not write ADCSRB
+ */
+void resetADCSRBForSingleEndedChannel() {
+    ADCSRB = 0;
+    // Gain stage and MUX5 switched, so next single ended reading must wait
+    startADCSettleForChannelSwitch();
+}
+
+/*
+ * The first conversion after switching to a gain channel may be inaccurate and is discarded, so this takes 2 conversions.
+ * Conversion time is defined as 0.104 milliseconds by ADC_PRESCALE in ADCUtils.h.
+ * @return -512 to 511 for bipolar mode, 0 to 1023 for unipolar mode
+ */
+int16_t readADCDifferentialChannelWithReference(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference) {
+    return readADCDifferentialChannelWithReferenceOversample(aChannel, aReference, 0);
+}
+
+/*
+ * Reading in free running mode. The first conversion is discarded.
+ * @param aOversampleExponent 0 to 6, 2^aOversampleExponent values are averaged
+ * @return rounded average, -512 to 511 for bipolar mode, 0 to 1023 for unipolar mode
+ */
+int16_t readADCDifferentialChannelWithReferenceOversample(const ADCDifferentialChannelStruct *aChannel, uint8_t aReference,
+        uint8_t aOversampleExponent) {
+    int32_t tSumValue = 0;
+    setADCDifferentialChannelAndReference(aChannel, aReference);
+
+    // ADSC-StartConversion ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag
+    ADCSRA = (_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | ADC_PRESCALE);
+
+    uint8_t tCount = _BV(aOversampleExponent);
+    for (uint8_t i = 0; i <= tCount; i++) {
+        /*
+         * wait for free running conversion to finish.
+         * Do not wait for ADSC here, since ADSC is only low for 1 ADC Clock cycle on free running conversion.
+         */
+        loop_until_bit_is_set(ADCSRA, ADIF);
+
+        ADCSRA |= _BV(ADIF); // clear bit to enable recognizing next conversion has finished
+        uint16_t tValue = ADCL | (ADCH << 8);
+        if (i > 0) {
+            // discard first conversion
+            tSumValue += getADCDifferentialValue(aChannel, tValue);
+        }
+    }
+    ADCSRA &= ~_BV(ADATE); // Disable auto-triggering (free running mode)
+    resetADCSRBForSingleEndedChannel();
+    // return rounded value, arithmetic shift rounds towards minus infinity
+    return ((tSumValue + (tCount >> 1)) >> aOversampleExponent);
+}
+
+/*
+ * Microvolt = ADCValue * ReferenceMillivolt * 1000 / (Gain * 512) for bipolar and / (Gain * 1024) for unipolar mode.
+ * 1000 / Gain is integer for all gains, and the computation is split to avoid 32 bit overflow.
+ * E.g. 20x gain, bipolar and 1100 mV reference gives 107 microvolt per LSB.
+ */
+int32_t getADCDifferentialMicrovolt(const ADCDifferentialChannelStruct *aChannel, int16_t aADCValue, uint16_t aReferenceMillivolt) {
+    int32_t tFullScale = READING_FOR_AREF;
+#if defined(ADC_DIFFERENTIAL_MUX5_MASK)
+    tFullScale = READING_FOR_AREF / 2;
+#else
+    if (aChannel->Flags & ADC_DIFFERENTIAL_FLAG_BIPOLAR) {
+        tFullScale = READING_FOR_AREF / 2;
+    }
+#endif
+    int16_t tMicrovoltPerMillivolt = 1000 / aChannel->Gain;
+    int32_t tProduct = (int32_t) aADCValue * aReferenceMillivolt;
+    return (tProduct / tFullScale) * tMicrovoltPerMillivolt + ((tProduct % tFullScale) * tMicrovoltPerMillivolt) / tFullScale;
+}
+#endif // defined(ADC_DIFFERENTIAL_CHANNELS_ARE_AVAILABLE)
+
+/*
+ * !!! Function without handling of switched reference and channel.!!!
+ * Use it ONLY if you only call getVCCVoltageSimple() or getVCCVoltageMillivoltSimple() in your program.
+ * !!! Resolution is only 20 millivolt !!!
+ * Raw reading of 1.1 V is 225 at 5 V.
+ * Raw reading of 1.1 V is 221 at 5.1 V.
+ * Raw reading of 1.1 V is 214 at 5.25 V (+5 %).
+ * Raw reading of 1.1 V is 204 at 5.5 V (+10 %).
+ */
+float getVCCVoltageSimple(void) {
+    // use AVCC with (optional) external capacitor at AREF pin as reference
+    float tVCC = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
+    return ((READING_FOR_AREF * ((float) ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL / 1000) * 4) / tVCC);
+}
+
+/*
+ * !!! Function without handling of switched reference and channel.!!!
+ * Use it ONLY if you only call getVCCVoltageSimple() or getVCCVoltageMillivoltSimple() in your program.
+ * !!! Resolution is only 20 millivolt !!!
+ */
+uint16_t getVCCVoltageMillivoltSimple(void) {
+    // use AVCC with external capacitor at AREF pin as reference
+    uint16_t tVCC = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
+    return (((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL * 4) / tVCC);
+}
+
+/*
+ * Gets the hypothetical 14 bit reading of VCC using 1.1 volt reference
+ * Similar to getVCCVoltageMillivolt() * 1024 / 1100
+ */
+uint16_t getVCCVoltageReadingFor1_1VoltReference(void) {
+    uint16_t tVCC = waitAndReadADCChannelWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
+    /*
+     * Do not switch back ADMUX to enable checkAndWaitForReferenceAndChannelToSwitch() to work correctly for the next measurement
+     */
+    return (((uint32_t)READING_FOR_AREF * READING_FOR_AREF) / tVCC);
+}
+
+/*
+ * !!! Resolution is only 20 millivolt !!!
+ */
+float getVCCVoltage(void) {
+    return (getVCCVoltageMillivolt() / 1000.0);
+}
+
+/*
+ * Read value of 1.1 volt internal channel using VCC (DEFAULT) as reference.
+ * Handles reference and channel switching by introducing the appropriate delays.
+ * !!! Resolution is only 20 millivolt !!!
+ * Raw reading of 1.1 V is 225 at 5 V.
+ * Raw reading of 1.1 V is 221 at 5.1 V.
+ * Raw reading of 1.1 V is 214 at 5.25 V (+5 %).
+ * Raw reading of 1.1 V is 204 at 5.5 V (+10 %).
+ */
+uint16_t getVCCVoltageMillivolt(void) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_VCC);
+    uint16_t tVCC = waitAndReadADCChannelWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
+    /*
+     * Do not switch back ADMUX to enable checkAndWaitForReferenceAndChannelToSwitch() to work correctly for the next measurement
+     */
+    return (((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL) / tVCC);
+}
+
+/*
+ * Does not set sVCCVoltageMillivolt
+ */
+uint16_t printVCCVoltageMillivolt(Print *aSerial) {
     aSerial->print(F("VCC="));
-    sVCCVoltageMillivolt = getVCCVoltageMillivolt();
+    uint16_t tVCCVoltageMillivolt = getVCCVoltageMillivolt();
+    aSerial->print(tVCCVoltageMillivolt);
+    aSerial->println(" mV");
+    return tVCCVoltageMillivolt;
+}
+
+void readAndPrintVCCVoltageMillivolt(Print *aSerial) {
+    aSerial->print(F("VCC="));
+    readVCCVoltageMillivolt();
     aSerial->print(sVCCVoltageMillivolt);
     aSerial->println(" mV");
 }
+
+#if defined(ADC_UTILS_PROFILING)
+static const char sADCProfileName0[] PROGMEM = "readADCChannelWithReference";
+static const char sADCProfileName1[] PROGMEM = "checkAndWaitForReferenceAndChannelToSwitch";
+static const char sADCProfileName2[] PROGMEM = "readADCChannelWithReferenceOversample";
+static const char sADCProfileName3[] PROGMEM = "readADCChannelMultiSamples*";
+static const char sADCProfileName4[] PROGMEM = "get/readVCCVoltageMillivolt";
+static const char sADCProfileName5[] PROGMEM = "getCPUTemperatureCentiDegree";
+static const char sADCProfileName6[] PROGMEM = "readADCScanList";
+static const char *const sADCProfileNames[ADC_PROFILE_NUMBER_OF_ENTRIES] PROGMEM = { sADCProfileName0, sADCProfileName1,
+        sADCProfileName2, sADCProfileName3, sADCProfileName4, sADCProfileName5, sADCProfileName6 };
+
+void printADCProfileMicros(Print *aSerial, uint32_t aTicks) {
+    // split to avoid overflow of aTicks * 256
+    aSerial->print(
+            (aTicks / ADC_PROFILE_TICKS_PER_MICROSECOND_SHIFT8) * 256
+                    + ((aTicks % ADC_PROFILE_TICKS_PER_MICROSECOND_SHIFT8) * 256) / ADC_PROFILE_TICKS_PER_MICROSECOND_SHIFT8);
+}
+
+/*
+ * Prints one line per called function with number of calls and minimum, average, maximum and total duration in microseconds
+ */
+void printADCProfile(Print *aSerial) {
+    aSerial->println(F("Calls min/avg/max/total us function"));
+    for (uint_fast8_t i = 0; i < ADC_PROFILE_NUMBER_OF_ENTRIES; ++i) {
+        ADCProfileEntryStruct *tEntry = &sADCProfile[i];
+        if (tEntry->NumberOfCalls == 0) {
+            continue;
+        }
+        aSerial->print(tEntry->NumberOfCalls);
+        aSerial->print(' ');
+        printADCProfileMicros(aSerial, tEntry->MinimumTicks);
+        aSerial->print('/');
+        printADCProfileMicros(aSerial, tEntry->TotalTicks / tEntry->NumberOfCalls);
+        aSerial->print('/');
+        printADCProfileMicros(aSerial, tEntry->MaximumTicks);
+        aSerial->print('/');
+        printADCProfileMicros(aSerial, tEntry->TotalTicks);
+        aSerial->print(' ');
+        aSerial->println((const __FlashStringHelper*) pgm_read_word(&sADCProfileNames[i]));
+    }
+    aSerial->print(F("Reference switches="));
+    aSerial->println(sADCProfileReferenceSwitchCount);
+}
+#endif
 /*
  * !!! Function without handling of switched reference and channel.!!!
  * Use it ONLY if you only call getVCCVoltageSimple() or getVCCVoltageMillivoltSimple() in your program.
@@ -607,7 +1386,7 @@ void readAndPrintVCCVoltageMillivolt(Print *aSerial) {
 void readVCCVoltageSimple(void) {
     // use AVCC with (optional) external capacitor at AREF pin as reference
     float tVCC = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
-    sVCCVoltage = (READING_FOR_AREF * (((float) ADC_INTERNAL_REFERENCE_MILLIVOLT) / 1000) * 4) / tVCC;
+    sVCCVoltage = (READING_FOR_AREF * (((float) ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL) / 1000) * 4) / tVCC;
 }
 
 /*
@@ -618,7 +1397,9 @@ void readVCCVoltageSimple(void) {
 void readVCCVoltageMillivoltSimple(void) {
     // use AVCC with external capacitor at AREF pin as reference
     uint16_t tVCCVoltageMillivoltRaw = readADCChannelMultiSamplesWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT, 4);
-    sVCCVoltageMillivolt = ((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT * 4) / tVCCVoltageMillivoltRaw;
+    sVCCVoltageMillivolt = ((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL * 4) / tVCCVoltageMillivoltRaw;
+    sVCCVoltageMillivoltMillis = millis();
+    sVCCVoltageMillivoltIsValid = true;
 }
 
 /*
@@ -635,11 +1416,45 @@ void readVCCVoltage(void) {
  * Sets also the sVCCVoltageMillivolt variable.
  */
 void readVCCVoltageMillivolt(void) {
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_VCC);
     uint16_t tVCCVoltageMillivoltRaw = waitAndReadADCChannelWithReference(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
     /*
      * Do not switch back ADMUX to enable checkAndWaitForReferenceAndChannelToSwitch() to work correctly for the next measurement
      */
-    sVCCVoltageMillivolt = ((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT) / tVCCVoltageMillivoltRaw;
+    sVCCVoltageMillivolt = ((uint32_t)READING_FOR_AREF * ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL) / tVCCVoltageMillivoltRaw;
+    sVCCVoltageMillivoltMillis = millis();
+    sVCCVoltageMillivoltIsValid = true;
+}
+
+/*
+ * Returns sVCCVoltageMillivolt, if it is not older than sVCCCacheMaximumAgeMillis.
+ * Otherwise VCC is measured and stored in sVCCVoltageMillivolt.
+ * With sVCCCacheMaximumAgeMillis == 0 (default), VCC is measured at each call.
+ */
+uint16_t getVCCVoltageMillivoltCached(void) {
+    refreshVCCVoltageMillivoltCacheIfStale();
+    return sVCCVoltageMillivolt;
+}
+
+/*
+ * Hook to be called e.g. in loop() when there is time for a VCC measurement,
+ * so that the next getVCCVoltageMillivoltCached() call is fast.
+ * @return true if VCC was measured
+ */
+bool refreshVCCVoltageMillivoltCacheIfStale(void) {
+    if (!sVCCVoltageMillivoltIsValid || sVCCCacheMaximumAgeMillis == 0
+            || millis() - sVCCVoltageMillivoltMillis > sVCCCacheMaximumAgeMillis) {
+        readVCCVoltageMillivolt();
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Forces a new measurement at next getVCCVoltageMillivoltCached() call, e.g. after switching on a big load
+ */
+void invalidateVCCVoltageMillivoltCache(void) {
+    sVCCVoltageMillivoltIsValid = false;
 }
 
 /*
@@ -648,21 +1463,56 @@ void readVCCVoltageMillivolt(void) {
  */
 uint16_t getVoltageMillivolt(uint16_t aVCCVoltageMillivolt, uint8_t aADCChannelForVoltageMeasurement) {
     uint16_t tInputVoltageRaw = waitAndReadADCChannelWithReference(aADCChannelForVoltageMeasurement, DEFAULT);
+#if defined(USE_ADC_CALIBRATION)
+    tInputVoltageRaw = getCalibratedADCValue(tInputVoltageRaw, DEFAULT);
+#endif
     return (aVCCVoltageMillivolt * (uint32_t) tInputVoltageRaw) / READING_FOR_AREF;
 }
 
 /*
  * Get voltage at ADC channel aADCChannelForVoltageMeasurement
- * Reference voltage VCC is determined just before
+ * Reference voltage VCC is determined just before or taken from cache, if not older than sVCCCacheMaximumAgeMillis
  */
 uint16_t getVoltageMillivolt(uint8_t aADCChannelForVoltageMeasurement) {
     uint16_t tInputVoltageRaw = waitAndReadADCChannelWithReference(aADCChannelForVoltageMeasurement, DEFAULT);
-    return (getVCCVoltageMillivolt() * (uint32_t) tInputVoltageRaw) / READING_FOR_AREF;
+#if defined(USE_ADC_CALIBRATION)
+    tInputVoltageRaw = getCalibratedADCValue(tInputVoltageRaw, DEFAULT);
+#endif
+    return (getVCCVoltageMillivoltCached() * (uint32_t) tInputVoltageRaw) / READING_FOR_AREF;
 }
 
 uint16_t getVoltageMillivoltWith_1_1VoltReference(uint8_t aADCChannelForVoltageMeasurement) {
     uint16_t tInputVoltageRaw = waitAndReadADCChannelWithReference(aADCChannelForVoltageMeasurement, INTERNAL);
-    return (ADC_INTERNAL_REFERENCE_MILLIVOLT * (uint32_t) tInputVoltageRaw) / READING_FOR_AREF;
+#if defined(USE_ADC_CALIBRATION)
+    tInputVoltageRaw = getCalibratedADCValue(tInputVoltageRaw, INTERNAL);
+#endif
+    return (ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL * (uint32_t) tInputVoltageRaw) / READING_FOR_AREF;
+}
+
+/*
+ * Reads all channels with one VCC measurement (from cache, if not older than sVCCCacheMaximumAgeMillis) for DEFAULT reference.
+ * For each channel, the millivolt value of a full scale reading is computed once, so the conversion is
+ * a multiplication and a shift by 10 instead of a 32 bit division.
+ * @param aReference DEFAULT or INTERNAL
+ * @return Reference voltage used for conversion in millivolt
+ */
+uint16_t readVoltagesMillivolt(ADCVoltageChannelStruct *aChannels, uint8_t aNumberOfChannels, uint8_t aReference) {
+    uint16_t tReferenceMillivolt;
+    if (aReference == DEFAULT) {
+        tReferenceMillivolt = getVCCVoltageMillivoltCached();
+    } else {
+        tReferenceMillivolt = ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL;
+    }
+    for (uint_fast8_t i = 0; i < aNumberOfChannels; ++i) {
+        uint16_t tInputVoltageRaw = waitAndReadADCChannelWithReference(aChannels[i].ADCChannelNumber, aReference);
+#if defined(USE_ADC_CALIBRATION)
+        tInputVoltageRaw = getCalibratedADCValue(tInputVoltageRaw, aReference);
+#endif
+        // Up to 1.4 million for 5.5 volt and maximum ratio, so product with the raw value still fits in 32 bit
+        uint32_t tFullScaleMillivolt = ((uint32_t) tReferenceMillivolt * aChannels[i].DividerRatio_shift8) >> 8;
+        aChannels[i].Millivolt = (tInputVoltageRaw * tFullScaleMillivolt) / READING_FOR_AREF; // shift by 10
+    }
+    return tReferenceMillivolt;
 }
 
 /*
@@ -671,7 +1521,7 @@ uint16_t getVoltageMillivoltWith_1_1VoltReference(uint8_t aADCChannelForVoltageM
  * and therefore a very low voltage drop.
  */
 bool isVCCUSBPowered() {
-    readVCCVoltageMillivolt();
+    getVCCVoltageMillivoltCached();
     return (VOLTAGE_USB_POWERED_LOWER_THRESHOLD_MILLIVOLT < sVCCVoltageMillivolt
             && sVCCVoltageMillivolt < VOLTAGE_USB_POWERED_UPPER_THRESHOLD_MILLIVOLT);
 }
@@ -680,7 +1530,7 @@ bool isVCCUSBPowered() {
  * Return true if sVCCVoltageMillivolt is > 4.3 V and < 4.95 V
  */
 bool isVCCUSBPowered(Print *aSerial) {
-    readVCCVoltageMillivolt();
+    getVCCVoltageMillivoltCached();
     aSerial->print(F("USB powered is "));
     bool tReturnValue;
     if (VOLTAGE_USB_POWERED_LOWER_THRESHOLD_MILLIVOLT
@@ -691,7 +1541,9 @@ bool isVCCUSBPowered(Print *aSerial) {
         tReturnValue = false;
         aSerial->print(F("false "));
     }
-    printVCCVoltageMillivolt(aSerial);
+    aSerial->print(F("VCC="));
+    aSerial->print(sVCCVoltageMillivolt);
+    aSerial->println(" mV");
     return tReturnValue;
 }
 
@@ -756,7 +1608,7 @@ bool isVCCUndervoltageMultipleTimes() {
  * Return true if VCC_EMERGENCY_UNDERVOLTAGE_THRESHOLD_MILLIVOLT (3 V) reached
  */
 bool isVCCUndervoltage() {
-    readVCCVoltageMillivolt();
+    getVCCVoltageMillivoltCached();
     return (sVCCVoltageMillivolt < VCC_UNDERVOLTAGE_THRESHOLD_MILLIVOLT);
 }
 
@@ -764,7 +1616,7 @@ bool isVCCUndervoltage() {
  * Return true if VCC_EMERGENCY_UNDERVOLTAGE_THRESHOLD_MILLIVOLT (3 V) reached
  */
 bool isVCCEmergencyUndervoltage() {
-    readVCCVoltageMillivolt();
+    getVCCVoltageMillivoltCached();
     return (sVCCVoltageMillivolt < VCC_EMERGENCY_UNDERVOLTAGE_THRESHOLD_MILLIVOLT);
 }
 
@@ -783,7 +1635,7 @@ void resetCounterForVCCUndervoltageMultipleTimes() {
  * @return true if 5 % overvoltage reached
  */
 bool isVCCOvervoltage() {
-    readVCCVoltageMillivolt();
+    getVCCVoltageMillivoltCached();
     return (sVCCVoltageMillivolt > VCC_OVERVOLTAGE_THRESHOLD_MILLIVOLT);
 }
 bool isVCCOvervoltageSimple() {
@@ -806,36 +1658,406 @@ bool isVCCTooHighSimple() {
     return tRawValue < 1126000 / VCC_OVERVOLTAGE_THRESHOLD_MILLIVOLT;
 }
 
+VCCSupervisionStruct sVCCSupervision;
+
+/*
+ * Sets the ranges of all conditions from the VCC_*_THRESHOLD_MILLIVOLT macros and resets their states.
+ * Registered callbacks are kept.
+ * @param aTicksPerCheck Number of tickVCCSupervision() calls between 2 VCC measurements, e.g. 1 for a watchdog ISR with 8 seconds period
+ */
+void initVCCSupervision(uint8_t aTicksPerCheck) {
+    static const uint16_t sVCCSupervisionRanges[VCC_SUPERVISION_NUMBER_OF_CONDITIONS][2] PROGMEM = { { 0,
+    VCC_UNDERVOLTAGE_THRESHOLD_MILLIVOLT }, { 0, VCC_EMERGENCY_UNDERVOLTAGE_THRESHOLD_MILLIVOLT }, {
+    VCC_OVERVOLTAGE_THRESHOLD_MILLIVOLT, 0xFFFF }, { VOLTAGE_USB_POWERED_LOWER_THRESHOLD_MILLIVOLT,
+    VOLTAGE_USB_POWERED_UPPER_THRESHOLD_MILLIVOLT } };
+
+    sVCCSupervision.TicksPerCheck = aTicksPerCheck;
+    sVCCSupervision.Ticks = aTicksPerCheck; // first check at first call of handleVCCSupervision()
+    for (uint_fast8_t i = 0; i < VCC_SUPERVISION_NUMBER_OF_CONDITIONS; ++i) {
+        VCCSupervisionConditionStruct *tCondition = &sVCCSupervision.Conditions[i];
+        tCondition->LowerMillivolt = pgm_read_word(&sVCCSupervisionRanges[i][0]);
+        tCondition->UpperMillivolt = pgm_read_word(&sVCCSupervisionRanges[i][1]);
+        tCondition->VotesRequired = VCC_SUPERVISION_VOTES_REQUIRED;
+        tCondition->History = 0;
+        tCondition->IsActive = false;
+    }
+    sVCCSupervision.Conditions[VCC_SUPERVISION_EMERGENCY_UNDERVOLTAGE].VotesRequired = 1;
+}
+
+/*
+ * @param aCallback Is called in the context of handleVCCSupervision() if the condition becomes active or inactive. NULL disables callback.
+ */
+void registerVCCSupervisionCallback(uint8_t aCondition, VCCSupervisionCallbackFunction aCallback) {
+    sVCCSupervision.Conditions[aCondition].Callback = aCallback;
+}
+
+/*
+ * To be called by an ISR. Does not access the ADC.
+ */
+void tickVCCSupervision() {
+    uint8_t tTicks = sVCCSupervision.Ticks;
+    if (tTicks < 0xFF) {
+        sVCCSupervision.Ticks = tTicks + 1;
+    }
+}
+
+/*
+ * To be called in loop. Returns immediately if no measurement is due.
+ * @return true if VCC was measured
+ */
+bool handleVCCSupervision() {
+    if (sVCCSupervision.Ticks < sVCCSupervision.TicksPerCheck) {
+        return false;
+    }
+    noInterrupts();
+    sVCCSupervision.Ticks -= sVCCSupervision.TicksPerCheck;
+    interrupts();
+
+    readVCCVoltageMillivolt();
+    evaluateVCCSupervision(sVCCVoltageMillivolt);
+    return true;
+}
+
+uint8_t countVCCSupervisionVotes(uint8_t aHistory) {
+    uint8_t tVotes = 0;
+    aHistory &= (1 << VCC_SUPERVISION_VOTING_WINDOW) - 1;
+    while (aHistory != 0) {
+        tVotes += aHistory & 0x01;
+        aHistory >>= 1;
+    }
+    return tVotes;
+}
+
+/*
+ * Applies hysteresis and N-of-M voting to a VCC value and calls the callbacks for each condition change.
+ * Can also be called directly with a VCC value measured elsewhere.
+ */
+void evaluateVCCSupervision(uint16_t aVCCMillivolt) {
+    for (uint_fast8_t i = 0; i < VCC_SUPERVISION_NUMBER_OF_CONDITIONS; ++i) {
+        VCCSupervisionConditionStruct *tCondition = &sVCCSupervision.Conditions[i];
+        uint16_t tLowerMillivolt = tCondition->LowerMillivolt;
+        uint16_t tUpperMillivolt = tCondition->UpperMillivolt;
+        if (tCondition->IsActive) {
+            // Hysteresis: an active condition has a larger range
+            if (tLowerMillivolt > VCC_SUPERVISION_HYSTERESIS_MILLIVOLT) {
+                tLowerMillivolt -= VCC_SUPERVISION_HYSTERESIS_MILLIVOLT;
+            } else {
+                tLowerMillivolt = 0;
+            }
+            if (tUpperMillivolt < 0xFFFF - VCC_SUPERVISION_HYSTERESIS_MILLIVOLT) {
+                tUpperMillivolt += VCC_SUPERVISION_HYSTERESIS_MILLIVOLT;
+            } else {
+                tUpperMillivolt = 0xFFFF;
+            }
+        }
+        tCondition->History <<= 1;
+        if (tLowerMillivolt <= aVCCMillivolt && aVCCMillivolt <= tUpperMillivolt) {
+            tCondition->History |= 0x01;
+        }
+
+        uint8_t tVotes = countVCCSupervisionVotes(tCondition->History);
+        bool tIsActive = tCondition->IsActive;
+        if (!tIsActive && tVotes >= tCondition->VotesRequired) {
+            tIsActive = true;
+        } else if (tIsActive && (VCC_SUPERVISION_VOTING_WINDOW - tVotes) >= VCC_SUPERVISION_VOTES_REQUIRED) {
+            // Leaving always requires VCC_SUPERVISION_VOTES_REQUIRED votes, even for the fast emergency undervoltage condition
+            tIsActive = false;
+        }
+        if (tIsActive != tCondition->IsActive) {
+            tCondition->IsActive = tIsActive;
+            // Votes before the change were counted with the other range, so the next change requires all new votes
+            tCondition->History = (tIsActive ? 0xFF : 0x00);
+#if defined(LOCAL_INFO)
+            Serial.print(F("VCC condition "));
+            Serial.print(i);
+            Serial.print(tIsActive ? F(" active at ") : F(" inactive at "));
+            Serial.print(aVCCMillivolt);
+            Serial.println(F(" mV"));
+#endif
+            if (tCondition->Callback != NULL) {
+                tCondition->Callback(i, tIsActive, aVCCMillivolt);
+            }
+        }
+    }
+}
+
+bool isVCCSupervisionConditionActive(uint8_t aCondition) {
+    return sVCCSupervision.Conditions[aCondition].IsActive;
+}
+
+/*
+ * Default values from datasheet. Can be changed by calibrateCPUTemperatureOffset() or readCPUTemperatureCalibrationFromEEPROM()
+ */
+CPUTemperatureCalibrationStruct sCPUTemperatureCalibration = { CPU_TEMPERATURE_OFFSET_RAW, CPU_TEMPERATURE_CENTI_DEGREE_PER_LSB_SHIFT8, 0 };
+
 /*
  * Temperature sensor is enabled by selecting the appropriate channel.
  * Different formula for 328P and 328PB!
  * !!! Function without handling of switched reference and channel.!!!
  * Use it ONLY if you only use INTERNAL reference (e.g. only call getTemperatureSimple()) in your program.
+ * @return temperature in 1/100 degree Celsius, e.g. 2512 for 25.12 degree
  */
-float getCPUTemperatureSimple(void) {
+int16_t getCPUTemperatureCentiDegreeSimple(void) {
 #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
-    return 0.0;
+    return 0;
 #else
     // use internal 1.1 volt as reference. 4 times oversample. Assume the signal has noise, but never verified :-(
-    uint16_t tTemperatureRaw = readADCChannelWithReferenceOversample(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL, 2);
+    int16_t tTemperatureRaw = readADCChannelWithReferenceOversample(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL, 2);
 #if defined(LOCAL_DEBUG)
     Serial.print(F("TempRaw="));
     Serial.println(tTemperatureRaw);
 #endif
+    tTemperatureRaw -= sCPUTemperatureCalibration.OffsetRaw;
+    // rounded for positive and negative values
+    return ((int32_t) tTemperatureRaw * sCPUTemperatureCalibration.CentiDegreePerLSB_shift8 + 0x80) >> 8;
+#endif
+}
 
-#if defined(__AVR_ATmega328PB__)
-    tTemperatureRaw -= 245;
-    return (float)tTemperatureRaw;
-#elif defined(__AVR_ATtiny85__)
-    tTemperatureRaw -= 273; // 273 and 1.1666 are values from the datasheet
-    return (float)tTemperatureRaw / 1.1666;
+/*
+ * Handles usage of 1.1 V reference and channel switching by introducing the appropriate delays.
+ * @return temperature in 1/100 degree Celsius
+ */
+int16_t getCPUTemperatureCentiDegree(void) {
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    return 0;
 #else
-    tTemperatureRaw -= 317;
-    return (float) tTemperatureRaw / 1.22;
+    ADC_PROFILE_FUNCTION(ADC_PROFILE_READ_CPU_TEMPERATURE);
+    // use internal 1.1 volt as reference
+    checkAndWaitForReferenceAndChannelToSwitch(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL);
+    return getCPUTemperatureCentiDegreeSimple();
 #endif
+}
+
+/*
+ * One point calibration. Adjusts the offset, so that the current temperature reading matches aActualCentiDegree.
+ * The factory calibration of the sensor can be +/- 10 degree, but the gain is quite accurate.
+ * Resolution of the offset is 1 LSB, which is 0.82 degree for ATmega328P.
+ */
+void calibrateCPUTemperatureOffset(int16_t aActualCentiDegree) {
+#if !defined(__AVR_ATmega1280__) && !defined(__AVR_ATmega2560__)
+    checkAndWaitForReferenceAndChannelToSwitch(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL);
+    int16_t tTemperatureRaw = readADCChannelWithReferenceOversample(ADC_TEMPERATURE_CHANNEL_MUX, INTERNAL, 2);
+    // rounded division of aActualCentiDegree * 256 by CentiDegreePerLSB_shift8
+    int32_t tActualRawDelta = (int32_t) aActualCentiDegree << 8;
+    uint16_t tGain = sCPUTemperatureCalibration.CentiDegreePerLSB_shift8;
+    if (tActualRawDelta >= 0) {
+        tActualRawDelta += tGain / 2;
+    } else {
+        tActualRawDelta -= tGain / 2;
+    }
+    sCPUTemperatureCalibration.OffsetRaw = tTemperatureRaw - (int16_t) (tActualRawDelta / tGain);
+#else
+    (void) aActualCentiDegree;
 #endif
 }
 
+uint8_t computeCPUTemperatureCalibrationChecksum(CPUTemperatureCalibrationStruct *aCalibration) {
+    uint8_t tSum = 0;
+    uint8_t *tBytePointer = (uint8_t*) aCalibration;
+    for (uint_fast8_t i = 0; i < offsetof(CPUTemperatureCalibrationStruct, Checksum); ++i) {
+        tSum += *tBytePointer++;
+    }
+    return ~tSum; // An erased EEPROM with all 0xFF gives an invalid checksum
+}
+
+/*
+ * Usage: CPUTemperatureCalibrationStruct sCPUTemperatureCalibrationEEPROM EEMEM;
+ *        readCPUTemperatureCalibrationFromEEPROM(&sCPUTemperatureCalibrationEEPROM);
+ * @return false and keep current calibration, if EEPROM content is not valid (e.g. never written)
+ */
+bool readCPUTemperatureCalibrationFromEEPROM(CPUTemperatureCalibrationStruct *aEEPROMAddress) {
+    CPUTemperatureCalibrationStruct tCalibration;
+    eeprom_read_block(&tCalibration, aEEPROMAddress, sizeof(tCalibration));
+    if (tCalibration.Checksum != computeCPUTemperatureCalibrationChecksum(&tCalibration)
+            || tCalibration.CentiDegreePerLSB_shift8 == 0) {
+        return false;
+    }
+    sCPUTemperatureCalibration = tCalibration;
+    return true;
+}
+
+void storeCPUTemperatureCalibrationToEEPROM(CPUTemperatureCalibrationStruct *aEEPROMAddress) {
+    sCPUTemperatureCalibration.Checksum = computeCPUTemperatureCalibrationChecksum(&sCPUTemperatureCalibration);
+    eeprom_update_block(&sCPUTemperatureCalibration, aEEPROMAddress, sizeof(sCPUTemperatureCalibration));
+}
+
+#if defined(USE_ADC_CALIBRATION)
+ADCCalibrationStruct sADCCalibration = { ADC_INTERNAL_REFERENCE_MILLIVOLT, 0, 25, { { ADC_CALIBRATION_GAIN_ONE_SHIFT14, 0 }, {
+ADC_CALIBRATION_GAIN_ONE_SHIFT14, 0 } }, 0 };
+
+void setADCCalibrationDefaults(void) {
+    sADCCalibration.InternalReferenceMillivolt = ADC_INTERNAL_REFERENCE_MILLIVOLT;
+    sADCCalibration.InternalReferenceMicrovoltPerDegree = 0;
+    sADCCalibration.CalibrationTemperatureDegree = 25;
+    for (uint_fast8_t i = 0; i < ADC_CALIBRATION_NUMBER_OF_REFERENCES; ++i) {
+        sADCCalibration.References[i].Gain_shift14 = ADC_CALIBRATION_GAIN_ONE_SHIFT14;
+        sADCCalibration.References[i].OffsetRaw = 0;
+    }
+    sADCInternalReferenceMillivolt = ADC_INTERNAL_REFERENCE_MILLIVOLT;
+}
+
+/*
+ * @return index for sADCCalibration.References or ADC_CALIBRATION_NUMBER_OF_REFERENCES if reference is not calibrated
+ */
+uint8_t getADCCalibrationIndex(uint8_t aReference) {
+    if (aReference == DEFAULT) {
+        return ADC_CALIBRATION_INDEX_DEFAULT;
+    } else if (aReference == INTERNAL) {
+        return ADC_CALIBRATION_INDEX_INTERNAL;
+    }
+    return ADC_CALIBRATION_NUMBER_OF_REFERENCES;
+}
+
+/*
+ * Sum of 64 readings, which gives 16 bit resolution
+ */
+uint16_t readADCChannelWithReference64Samples(uint8_t aADCChannelNumber, uint8_t aReference) {
+    checkAndWaitForReferenceAndChannelToSwitch(aADCChannelNumber, aReference);
+    return readADCChannelMultiSamplesWithReferenceAndPrescaler(aADCChannelNumber, aReference, ADC_PRESCALE, 64);
+}
+
+/*
+ * Measures the internal reference against VCC, which must be known e.g. by measuring it with a multimeter or by a precise regulator.
+ * Resolution is around 0.1 millivolt by using 64 samples.
+ * @param aTemperatureDegree CPU temperature at calibration, used for temperature compensation by updateADCCalibrationForTemperature()
+ * @return the internal reference voltage in millivolt, which is also stored in sADCCalibration and sADCInternalReferenceMillivolt
+ */
+uint16_t calibrateADCInternalReference(uint16_t aVCCMillivolt, int8_t aTemperatureDegree) {
+    uint32_t tReferenceRaw64 = readADCChannelWithReference64Samples(ADC_1_1_VOLT_CHANNEL_MUX, DEFAULT);
+    // rounded
+    uint16_t tReferenceMillivolt = ((tReferenceRaw64 * aVCCMillivolt) + (READING_FOR_AREF * 32L)) / (READING_FOR_AREF * 64L);
+    sADCCalibration.InternalReferenceMillivolt = tReferenceMillivolt;
+    sADCCalibration.CalibrationTemperatureDegree = aTemperatureDegree;
+    sADCInternalReferenceMillivolt = tReferenceMillivolt;
+    invalidateVCCVoltageMillivoltCache();
+    return tReferenceMillivolt;
+}
+
+/*
+ * Reads the internal GND channel to determine the offset of the ADC for this reference
+ */
+void calibrateADCReferenceOffset(uint8_t aReference) {
+    uint8_t tIndex = getADCCalibrationIndex(aReference);
+    if (tIndex < ADC_CALIBRATION_NUMBER_OF_REFERENCES) {
+        uint16_t tOffsetRaw64 = readADCChannelWithReference64Samples(ADC_GND_CHANNEL_MUX, aReference);
+        sADCCalibration.References[tIndex].OffsetRaw = (tOffsetRaw64 + 32) >> 6;
+    }
+}
+
+/*
+ * Requires a known voltage at the input. Call calibrateADCReferenceOffset() and for DEFAULT reference, calibrateADCInternalReference() before.
+ * @param aInputMillivolt Should be near the upper end of the range, i.e. near VCC or 1.1 volt.
+ * @return false if reference is not calibrated or measured gain deviates more than 25 % from 1.0
+ */
+bool calibrateADCReferenceGain(uint8_t aReference, uint8_t aADCChannelNumber, uint16_t aInputMillivolt) {
+    uint8_t tIndex = getADCCalibrationIndex(aReference);
+    if (tIndex >= ADC_CALIBRATION_NUMBER_OF_REFERENCES) {
+        return false;
+    }
+    uint16_t tReferenceMillivolt = sADCInternalReferenceMillivolt;
+    if (aReference == DEFAULT) {
+        tReferenceMillivolt = getVCCVoltageMillivolt();
+    }
+    int32_t tMeasuredRaw64 = readADCChannelWithReference64Samples(aADCChannelNumber, aReference)
+            - (sADCCalibration.References[tIndex].OffsetRaw * 64L);
+    uint32_t tExpectedRaw64 = ((uint32_t) aInputMillivolt * (READING_FOR_AREF * 64L)) / tReferenceMillivolt;
+    if (tMeasuredRaw64 <= 0) {
+        return false;
+    }
+    uint32_t tGain_shift14 = ((tExpectedRaw64 << 14) + (tMeasuredRaw64 / 2)) / tMeasuredRaw64;
+    if (tGain_shift14 < (ADC_CALIBRATION_GAIN_ONE_SHIFT14 * 3) / 4 || tGain_shift14 > (ADC_CALIBRATION_GAIN_ONE_SHIFT14 * 5) / 4) {
+        return false;
+    }
+    sADCCalibration.References[tIndex].Gain_shift14 = tGain_shift14;
+    return true;
+}
+
+/*
+ * Computes sADCInternalReferenceMillivolt for the current temperature, e.g. getCPUTemperatureCentiDegree() / 100.
+ * Call it from time to time, if InternalReferenceMicrovoltPerDegree is known.
+ */
+void updateADCCalibrationForTemperature(int8_t aTemperatureDegree) {
+    int32_t tDeltaMicrovolt = (int32_t) sADCCalibration.InternalReferenceMicrovoltPerDegree
+            * (aTemperatureDegree - sADCCalibration.CalibrationTemperatureDegree);
+    // rounded for positive and negative values
+    if (tDeltaMicrovolt >= 0) {
+        tDeltaMicrovolt += 500;
+    } else {
+        tDeltaMicrovolt -= 500;
+    }
+    sADCInternalReferenceMillivolt = sADCCalibration.InternalReferenceMillivolt + (int16_t) (tDeltaMicrovolt / 1000);
+}
+
+/*
+ * Applies offset and gain of the reference with integer multiply and shift
+ * @return corrected ADC value, which can be > MAX_ADC_VALUE if gain > 1.0
+ */
+uint16_t getCalibratedADCValue(uint16_t aADCValue, uint8_t aReference) {
+    uint8_t tIndex = getADCCalibrationIndex(aReference);
+    if (tIndex >= ADC_CALIBRATION_NUMBER_OF_REFERENCES) {
+        return aADCValue;
+    }
+    int16_t tValue = aADCValue - sADCCalibration.References[tIndex].OffsetRaw;
+    if (tValue <= 0) {
+        return 0;
+    }
+    return ((uint32_t) tValue * sADCCalibration.References[tIndex].Gain_shift14 + (ADC_CALIBRATION_GAIN_ONE_SHIFT14 / 2)) >> 14;
+}
+
+/*
+ * CRC-8 with polynomial 0x07. Detects all single and double bit errors of the small calibration structure.
+ */
+uint8_t computeADCCalibrationCRC8(const uint8_t *aData, uint8_t aLength) {
+    uint8_t tCRC = 0;
+    while (aLength-- > 0) {
+        tCRC ^= *aData++;
+        for (uint_fast8_t i = 0; i < 8; ++i) {
+            if (tCRC & 0x80) {
+                tCRC = (tCRC << 1) ^ 0x07;
+            } else {
+                tCRC <<= 1;
+            }
+        }
+    }
+    return tCRC;
+}
+
+/*
+ * Usage: ADCCalibrationStruct sADCCalibrationEEPROM EEMEM;
+ *        readADCCalibrationFromEEPROM(&sADCCalibrationEEPROM);
+ * @return false and keep current calibration, if EEPROM content is not valid (e.g. never written)
+ */
+bool readADCCalibrationFromEEPROM(ADCCalibrationStruct *aEEPROMAddress) {
+    ADCCalibrationStruct tCalibration;
+    eeprom_read_block(&tCalibration, aEEPROMAddress, sizeof(tCalibration));
+    // The check for 0xFFFF is required, since the CRC of an erased EEPROM can be valid
+    if (tCalibration.CRC8 != computeADCCalibrationCRC8((const uint8_t*) &tCalibration, offsetof(ADCCalibrationStruct, CRC8))
+            || tCalibration.InternalReferenceMillivolt == 0xFFFF) {
+        return false;
+    }
+    sADCCalibration = tCalibration;
+    updateADCCalibrationForTemperature(tCalibration.CalibrationTemperatureDegree);
+    invalidateVCCVoltageMillivoltCache();
+    return true;
+}
+
+void storeADCCalibrationToEEPROM(ADCCalibrationStruct *aEEPROMAddress) {
+    sADCCalibration.CRC8 = computeADCCalibrationCRC8((const uint8_t*) &sADCCalibration, offsetof(ADCCalibrationStruct, CRC8));
+    eeprom_update_block(&sADCCalibration, aEEPROMAddress, sizeof(sADCCalibration));
+}
+#endif // defined(USE_ADC_CALIBRATION)
+
+/*
+ * Temperature sensor is enabled by selecting the appropriate channel.
+ * Different formula for 328P and 328PB!
+ * !!! Function without handling of switched reference and channel.!!!
+ * Use it ONLY if you only use INTERNAL reference (e.g. only call getTemperatureSimple()) in your program.
+ * Uses the calibration of getCPUTemperatureCentiDegreeSimple().
+ */
+float getCPUTemperatureSimple(void) {
+    return getCPUTemperatureCentiDegreeSimple() / 100.0;
+}
+
 /*
  * Handles usage of 1.1 V reference and channel switching by introducing the appropriate delays.
  */
@@ -852,6 +2074,340 @@ float getCPUTemperature(void) {
 #endif
 }
 
+#if defined(USE_ADC_SAMPLER)
+/*
+ * Ring buffer for the interrupt driven sampler.
+ * Indexes are free running and masked on access, so (WriteIndex - ReadIndex) is always the number of stored values.
+ * Each index is written by only one side and 8 bit accesses are atomic, so no locking is required.
+ */
+volatile uint16_t sADCSamplerBuffer[ADC_SAMPLER_BUFFER_SIZE];
+volatile uint8_t sADCSamplerWriteIndex;
+volatile uint8_t sADCSamplerReadIndex;
+volatile uint16_t sADCSamplerOverrunCount;
+
+/*
+ * Starts free running conversions. Each conversion result is stored by the ADC ISR.
+ * Channel switching delays are not handled here, so call checkAndWaitForReferenceAndChannelToSwitch() before if required.
+ * @param aPrescale can be one of ADC_PRESCALE2, ADC_PRESCALE4, 8, 16, 32, 64, 128.
+ *                  ADC_PRESCALE32 gives 26 us conversion time (38 kHz) for 16 MHz Arduino, leaving enough time for the ISR.
+ */
+void startADCSampler(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale) {
+    sADCSamplerWriteIndex = 0;
+    sADCSamplerReadIndex = 0;
+    sADCSamplerOverrunCount = 0;
+    ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
+
+    ADCSRB = 0; // Free running mode. Only active if ADATE is set to 1.
+    // ADSC-StartConversion ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag ADIE-Enable Interrupt
+    ADCSRA = (_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | aPrescale);
+}
+
+/*
+ * The current conversion is finished, but its value is not stored.
+ * Values already stored can still be read.
+ */
+void stopADCSampler() {
+    ADCSRA &= ~(_BV(ADATE) | _BV(ADIE)); // Disable auto-triggering (free running mode) and interrupt
+}
+
+uint8_t getADCSamplerNumberOfAvailableSamples() {
+    return sADCSamplerWriteIndex - sADCSamplerReadIndex;
+}
+
+/*
+ * @return false if buffer is empty. Value is not removed from buffer.
+ */
+bool peekADCSampler(uint16_t *aADCValuePointer) {
+    uint8_t tReadIndex = sADCSamplerReadIndex;
+    if (sADCSamplerWriteIndex == tReadIndex) {
+        return false;
+    }
+    *aADCValuePointer = sADCSamplerBuffer[tReadIndex & ADC_SAMPLER_BUFFER_MASK];
+    return true;
+}
+
+/*
+ * @return false if buffer is empty.
+ */
+bool readADCSampler(uint16_t *aADCValuePointer) {
+    uint8_t tReadIndex = sADCSamplerReadIndex;
+    if (sADCSamplerWriteIndex == tReadIndex) {
+        return false;
+    }
+    *aADCValuePointer = sADCSamplerBuffer[tReadIndex & ADC_SAMPLER_BUFFER_MASK];
+    // Release the entry after reading it, otherwise the ISR may overwrite it before we read it
+    sADCSamplerReadIndex = tReadIndex + 1;
+    return true;
+}
+
+uint16_t getAndResetADCSamplerOverrunCount() {
+    noInterrupts();
+    uint16_t tOverrunCount = sADCSamplerOverrunCount;
+    sADCSamplerOverrunCount = 0;
+    interrupts();
+    return tOverrunCount;
+}
+
+/*
+ * Producer part of the ring buffer, called by the ISR.
+ * Does not access any ADC register, so it can also be used to feed the buffer from other sources.
+ * If buffer is full, the value is dropped and the overrun counter is incremented.
+ */
+void storeADCSamplerValue(uint16_t aADCValue) {
+    uint8_t tWriteIndex = sADCSamplerWriteIndex;
+    if ((uint8_t) (tWriteIndex - sADCSamplerReadIndex) >= ADC_SAMPLER_BUFFER_SIZE) {
+        sADCSamplerOverrunCount++;
+    } else {
+        sADCSamplerBuffer[tWriteIndex & ADC_SAMPLER_BUFFER_MASK] = aADCValue;
+        // Publish the entry after writing it
+        sADCSamplerWriteIndex = tWriteIndex + 1;
+    }
+}
+
+#if defined(ADC_SAMPLER_TIMER1_TRIGGER_IS_AVAILABLE)
+/*
+ * Samples at aSampleFrequencyHertz triggered by Timer1 compare match B. Timer1 runs in CTC mode with OCR1A as TOP.
+ * Timer1 prescaler 1, 8 or 64 is chosen to get the best resolution.
+ * Values dropped because of a full buffer can be read by getAndResetADCSamplerOverrunCount().
+ * Triggers are missed without being counted, if the ADC interrupt is blocked for more than one sample period,
+ * because then OCF1B is still set at the next compare match. Detect this by comparing the number of samples with the elapsed time.
+ * Channel switching delays are not handled here, so call checkAndWaitForReferenceAndChannelToSwitch() before if required.
+ * @param aPrescale ADC prescaler. The ADC conversion time of 13.5 ADC clocks must be shorter than the sample period.
+ * @return Achieved sample frequency in millihertz or 0 if sample frequency cannot be reached.
+ *         E.g. 1000000 for 1 kHz or 3000187 for 3 kHz at 16 MHz, if the sample period is not a multiple of the Timer1 clock.
+ */
+uint32_t startADCSamplerWithTimer1Trigger(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aPrescale,
+        uint16_t aSampleFrequencyHertz) {
+    if (aSampleFrequencyHertz == 0 || (F_CPU / aSampleFrequencyHertz) < (14UL << aPrescale)) {
+        return 0; // ADC cannot convert this fast
+    }
+
+    /*
+     * Choose smallest Timer1 prescaler, which gives a period of <= 16 bit.
+     * Prescaler 64 is the maximum to keep the millihertz computation below in 32 bit for 16 MHz.
+     */
+    uint8_t tPrescaleShift;
+    uint8_t tClockSelectBits;
+    if ((F_CPU / aSampleFrequencyHertz) <= 0x10000) {
+        tPrescaleShift = 0;
+        tClockSelectBits = _BV(CS10);
+    } else if ((F_CPU / 8 / aSampleFrequencyHertz) <= 0x10000) {
+        tPrescaleShift = 3;
+        tClockSelectBits = _BV(CS11);
+    } else if ((F_CPU / 64 / aSampleFrequencyHertz) <= 0x10000) {
+        tPrescaleShift = 6;
+        tClockSelectBits = _BV(CS11) | _BV(CS10);
+    } else {
+        return 0; // too slow
+    }
+    // rounded number of timer clocks per sample
+    uint32_t tTimerClocksPerSample = ((F_CPU >> tPrescaleShift) + (aSampleFrequencyHertz / 2)) / aSampleFrequencyHertz;
+    if (tTimerClocksPerSample > 0x10000) {
+        tTimerClocksPerSample = 0x10000; // can happen by rounding
+    }
+
+    sADCSamplerWriteIndex = 0;
+    sADCSamplerReadIndex = 0;
+    sADCSamplerOverrunCount = 0;
+    ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
+
+    TCCR1B = 0; // stop timer
+    TCCR1A = 0;
+    TCNT1 = 0;
+    OCR1A = tTimerClocksPerSample - 1; // TOP
+    OCR1B = tTimerClocksPerSample - 1; // Trigger ADC at TOP
+    TIFR1 = _BV(OCF1B); // clear flag, the ADC is triggered by its rising edge
+
+    ADCSRB = ADC_TRIGGER_SOURCE_TIMER1_COMPARE_B;
+    // ADATE-AutoTriggerEnable ADIF-Reset Interrupt Flag ADIE-Enable Interrupt. First conversion is started by timer.
+    ADCSRA = (_BV(ADEN) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | aPrescale);
+    TCCR1B = _BV(WGM12) | tClockSelectBits; // CTC mode with OCR1A as TOP, start timer
+
+    /*
+     * Compute achieved frequency in millihertz without float and overflow
+     */
+    uint32_t tCPUClocksPerSample = tTimerClocksPerSample << tPrescaleShift;
+    return ((F_CPU / tCPUClocksPerSample) * 1000) + (((F_CPU % tCPUClocksPerSample) * 1000) / tCPUClocksPerSample);
+}
+
+void stopADCSamplerWithTimer1Trigger() {
+    stopADCSampler();
+    TCCR1B = 0; // stop timer
+    ADCSRB = 0; // Free running mode for the other functions
+}
+#endif // defined(ADC_SAMPLER_TIMER1_TRIGGER_IS_AVAILABLE)
+
+#if defined(USE_ADC_CAPTURE)
+ADCCaptureStruct sADCCapture; // TriggerMode is initialized with ADC_CAPTURE_TRIGGER_DISABLED
+
+/*
+ * Switches the sampler to capture mode. Must be called before each startADCSampler() or startADCSamplerWithTimer1Trigger().
+ * @param aPostTriggerSamples 0 to ADC_SAMPLER_BUFFER_SIZE - 1. The remaining buffer entries hold the trigger sample and the pre-trigger history.
+ */
+void setADCCaptureTrigger(uint8_t aTriggerMode, uint16_t aThreshold, uint16_t aThresholdHigh, uint8_t aPostTriggerSamples) {
+    stopADCSampler();
+    if (aPostTriggerSamples >= ADC_SAMPLER_BUFFER_SIZE) {
+        aPostTriggerSamples = ADC_SAMPLER_BUFFER_SIZE - 1;
+    }
+    sADCCapture.TriggerMode = aTriggerMode;
+    sADCCapture.Threshold = aThreshold;
+    sADCCapture.ThresholdHigh = aThresholdHigh;
+    sADCCapture.PostTriggerSamples = aPostTriggerSamples;
+    sADCCapture.State = ADC_CAPTURE_STATE_FILLING;
+    // Trigger is armed after the pre-trigger part of the buffer is filled
+    sADCCapture.RemainingSamples = ADC_SAMPLER_BUFFER_SIZE - aPostTriggerSamples;
+}
+
+/*
+ * Back to normal sampler operation
+ */
+void disableADCCapture() {
+    stopADCSampler();
+    sADCCapture.TriggerMode = ADC_CAPTURE_TRIGGER_DISABLED;
+}
+
+/*
+ * Called by the ISR in capture mode instead of storeADCSamplerValue().
+ * Stops the sampler when the buffer is frozen.
+ */
+void storeADCCaptureValue(uint16_t aADCValue) {
+    uint8_t tState = sADCCapture.State;
+    if (tState == ADC_CAPTURE_STATE_FROZEN) {
+        return;
+    }
+    uint8_t tWriteIndex = sADCSamplerWriteIndex;
+    sADCSamplerBuffer[tWriteIndex & ADC_SAMPLER_BUFFER_MASK] = aADCValue;
+    sADCSamplerWriteIndex = tWriteIndex + 1;
+
+    if (tState == ADC_CAPTURE_STATE_FILLING) {
+        if (--sADCCapture.RemainingSamples == 0) {
+            tState = ADC_CAPTURE_STATE_ARMED;
+        }
+    } else if (tState == ADC_CAPTURE_STATE_ARMED) {
+        uint16_t tLastValue = sADCCapture.LastValue;
+        uint16_t tThreshold = sADCCapture.Threshold;
+        bool tIsTriggered;
+        if (sADCCapture.TriggerMode == ADC_CAPTURE_TRIGGER_RISING) {
+            tIsTriggered = (tLastValue < tThreshold && aADCValue >= tThreshold);
+        } else if (sADCCapture.TriggerMode == ADC_CAPTURE_TRIGGER_FALLING) {
+            tIsTriggered = (tLastValue >= tThreshold && aADCValue < tThreshold);
+        } else {
+            tIsTriggered = (aADCValue < tThreshold || aADCValue > sADCCapture.ThresholdHigh);
+        }
+        if (tIsTriggered) {
+            sADCCapture.RemainingSamples = sADCCapture.PostTriggerSamples;
+            tState = ADC_CAPTURE_STATE_TRIGGERED;
+        }
+    } else {
+        // ADC_CAPTURE_STATE_TRIGGERED
+        sADCCapture.RemainingSamples--;
+    }
+    if (tState == ADC_CAPTURE_STATE_TRIGGERED && sADCCapture.RemainingSamples == 0) {
+        tState = ADC_CAPTURE_STATE_FROZEN;
+        stopADCSampler();
+    }
+    sADCCapture.State = tState;
+    sADCCapture.LastValue = aADCValue;
+}
+
+bool isADCCaptureFrozen() {
+    return sADCCapture.State == ADC_CAPTURE_STATE_FROZEN;
+}
+
+/*
+ * @return Index of the trigger sample for getADCCaptureValue()
+ */
+uint8_t getADCCaptureTriggerIndex() {
+    return (ADC_SAMPLER_BUFFER_SIZE - 1) - sADCCapture.PostTriggerSamples;
+}
+
+/*
+ * Only valid if isADCCaptureFrozen() returns true.
+ * @param aIndex 0 is the oldest value, ADC_SAMPLER_BUFFER_SIZE - 1 the newest one.
+ */
+uint16_t getADCCaptureValue(uint8_t aIndex) {
+    // After freezing, the buffer is full and the oldest value is at the write index
+    return sADCSamplerBuffer[(uint8_t) (sADCSamplerWriteIndex + aIndex) & ADC_SAMPLER_BUFFER_MASK];
+}
+#endif // defined(USE_ADC_CAPTURE)
+
+ISR(ADC_vect) {
+#  if defined(USE_ADC_NOISE_REDUCTION_SLEEP)
+    if (!(ADCSRA & _BV(ADATE))) {
+        return; // Single conversion of readADCChannelWithReferenceSleep(), which only requires the wake up
+    }
+#  endif
+    WordUnionForADCUtils tUValue;
+    tUValue.UByte.LowByte = ADCL;
+    tUValue.UByte.HighByte = ADCH;
+#if defined(ADC_SAMPLER_TIMER1_TRIGGER_IS_AVAILABLE)
+    if ((ADCSRB & (_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0))) == ADC_TRIGGER_SOURCE_TIMER1_COMPARE_B) {
+        // The flag is not cleared by the ADC. Without clearing, no further trigger would happen.
+        // Not cleared for other trigger sources, since it may belong to another user of Timer1.
+        TIFR1 = _BV(OCF1B);
+    }
+#endif
+#if defined(USE_ADC_CAPTURE)
+    if (sADCCapture.TriggerMode != ADC_CAPTURE_TRIGGER_DISABLED) {
+        storeADCCaptureValue(tUValue.UWord);
+        return;
+    }
+#endif
+    storeADCSamplerValue(tUValue.UWord);
+}
+#elif defined(USE_ADC_NOISE_REDUCTION_SLEEP)
+EMPTY_INTERRUPT(ADC_vect); // Only required for wake up
+#endif // defined(USE_ADC_SAMPLER)
+
+#if defined(USE_ADC_NOISE_REDUCTION_SLEEP)
+/*
+ * Entering ADC noise reduction sleep mode starts the conversion and the ADC interrupt wakes us up.
+ * Another interrupt may wake us up before conversion has finished, so sleep again until conversion has finished.
+ * Sleep mode settings (e.g. set by initSleep()) and interrupt enable state are restored.
+ */
+uint16_t readADCChannelWithReferenceSleep(uint8_t aADCChannelNumber, uint8_t aReference) {
+    WordUnionForADCUtils tUValue;
+    ADMUX = aADCChannelNumber | (aReference << SHIFT_VALUE_FOR_REFERENCE);
+
+    uint8_t tOldSREG = SREG;
+    uint8_t tOldSleepControl = ADC_SLEEP_CONTROL_REGISTER;
+    set_sleep_mode(SLEEP_MODE_ADC);
+    sleep_enable();
+
+    // ADIF-Reset Interrupt Flag ADIE-Enable Interrupt - NOT free running mode. Conversion is started by sleep.
+    ADCSRA = (_BV(ADEN) | _BV(ADIF) | _BV(ADIE) | ADC_PRESCALE);
+    do {
+        sei(); // Interrupt is required for wake up
+        sleep_cpu();
+    } while (bit_is_set(ADCSRA, ADSC));
+
+    ADCSRA &= ~_BV(ADIE);
+    ADC_SLEEP_CONTROL_REGISTER = (ADC_SLEEP_CONTROL_REGISTER & ~ADC_SLEEP_CONTROL_MASK)
+            | (tOldSleepControl & ADC_SLEEP_CONTROL_MASK);
+    SREG = tOldSREG;
+
+    // Get value
+    tUValue.UByte.LowByte = ADCL;
+    tUValue.UByte.HighByte = ADCH;
+    return tUValue.UWord;
+}
+
+/*
+ * Each conversion is done in ADC noise reduction sleep mode.
+ * Conversion time is defined as 0.104 milliseconds by ADC_PRESCALE in ADCUtils.h, but there is some additional time for wake up.
+ * @param aOversampleExponent maximum is 6 (64 samples)
+ */
+uint16_t readADCChannelWithReferenceOversampleSleep(uint8_t aADCChannelNumber, uint8_t aReference, uint8_t aOversampleExponent) {
+    uint16_t tSumValue = 0;
+    uint8_t tCount = _BV(aOversampleExponent);
+    for (uint8_t i = 0; i < tCount; i++) {
+        tSumValue += readADCChannelWithReferenceSleep(aADCChannelNumber, aReference);
+    }
+    // return rounded value
+    return ((tSumValue + (tCount >> 1)) >> aOversampleExponent);
+}
+#endif // defined(USE_ADC_NOISE_REDUCTION_SLEEP)
+
 #else // defined(ADC_UTILS_ARE_AVAILABLE)
 // Dummy definition of functions defined in ADCUtils to compile examples for non AVR platforms without errors
 /*
@@ -871,6 +2427,9 @@ uint16_t readADCChannelWithReferenceOversample(uint8_t aChannelNumber __attribut
 float getCPUTemperature() {
     return 20.0;
 }
+int16_t getCPUTemperatureCentiDegree() {
+    return 2000;
+}
 float getVCCVoltage() {
     return 3.3;
 }
@@ -85,6 +85,7 @@
 //#define PRINT_OF_RESISTOR_MEASURMENT_VOLTAGE // enables print of voltage at resistor under measurement (0 to VCC).
 //#define PRINT_OF_VCC
 //#define ADC_INTERNAL_REFERENCE_MILLIVOLT    1100UL // Change to value measured at the AREF pin. If value > real AREF voltage, measured values are > real values
+//#define USE_ADC_CALIBRATION // Use the internal reference voltage measured by calibrateADCInternalReference() or stored in EEPROM
 //#define USE_LCD       // To enable LCD output at the externally provided myLCD object
 //#define USE_2004_LCD // for rendering Resistance and resistance voltage in one line
 //#define LCD_OBJECT_NAME         myLCD
@@ -189,7 +190,7 @@ uint16_t measureVoltage(uint16_t tVCCVoltageMillivolt) {
         /*
          * Voltage at ADC input is below VCC
          */
-        if (tInputVoltageMillivolt < (ADC_INTERNAL_REFERENCE_MILLIVOLT - 50)) {
+        if (tInputVoltageMillivolt < (ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL - 50)) {
             /*
              * Voltage at ADC input is below 1.05 volt, so we can switch to
              * the internal 1.1 volt reference to get a better resolution (around 4 times better => ~ 1 mV)
@@ -264,7 +265,7 @@ bool measureResistance(uint16_t aVCCVoltageMillivolt, ResistanceMeasurementResul
         tInputRawReading = waitAndReadADCChannelWithReference(MEASUREMENT_CHANNEL, INTERNAL);
 
         // The compensated VCC reading at 1.1 volt reference
-        uint16_t tReadingAtVCCReference = (aVCCVoltageMillivolt * READING_FOR_AREF) / 1100;
+        uint16_t tReadingAtVCCReference = ((uint32_t) aVCCVoltageMillivolt * READING_FOR_AREF) / ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL;
 
         tRxOhm = (RESISTOR_2_TO_INPUT_KOHM * 1000L * tInputRawReading) / (tReadingAtVCCReference - tInputRawReading);
 
@@ -300,7 +301,7 @@ bool measureResistance(uint16_t aVCCVoltageMillivolt, ResistanceMeasurementResul
         /*
          * Input voltage for 1.1 volt reference
          */
-        tInputVoltage = tInputRawReading * 1100L / READING_FOR_AREF;
+        tInputVoltage = tInputRawReading * (uint32_t) ADC_INTERNAL_REFERENCE_MILLIVOLT_ACTUAL / READING_FOR_AREF;
     }
 #if defined(LOCAL_DEBUG)
     Serial.print(F("ResistanceRange="));
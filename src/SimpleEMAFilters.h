@@ -28,6 +28,21 @@
 
 void doLowpass_int16(int16_t *aLowpassAccumulator_int16, int16_t aInputValue, uint8_t aAlpha_shift8);
 void doLowpass_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int16_t aInputValue, uint8_t aAlpha_shift8);
+void doLowpass_int32_shift8_C(int32_t *aLowpassAccumulator_int32_shift8, int16_t aInputValue, uint8_t aAlpha_shift8);
+void doDoubleLowpass_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int32_t *aDoubleLowpassAccumulator_int32_shift8,
+        int16_t aInputValue, uint8_t aShiftValue) __attribute__ ((deprecated ("Use EMALowpassCascade<int32_t, Shift, 2>")));
+
+/*
+ * Block variants for buffered samples. aOutputValues may be identical to aInputValues.
+ */
+void doLowpassShift_int16_block(int16_t *aLowpassAccumulator_int16, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aShiftValue);
+void doLowpass_int16_block(int16_t *aLowpassAccumulator_int16, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aAlpha_shift8);
+void doLowpassShift_int32_shift8_block(int32_t *aLowpassAccumulator_int32_shift8, const int16_t *aInputValues,
+        int16_t *aOutputValues, uint16_t aNumberOfValues, uint8_t aShiftValue);
+void doLowpass_int32_shift8_block(int32_t *aLowpassAccumulator_int32_shift8, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aAlpha_shift8);
 
 struct BiquadFilter16Struct {
     int16_t BiQuadLowpass = 0;
@@ -47,11 +62,343 @@ struct BiquadFilter32Struct {
 
 void doBiquad_int16(struct BiquadFilter16Struct *BiquadFilter16Ptr, int16_t aInputValue);
 void doBiquad_int32(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aInputValue);
+void doBiquad_int32_C(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aInputValue); // Reference for assembler kernel
 void initBiquad16(struct BiquadFilter16Struct *BiquadFilter16Ptr, int16_t aDampingFactor_shift8, uint8_t aAlpha_shift8);
 void initBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aDampingFactor_shift8, uint8_t aAlpha_shift8);
 void resetBiquad16(struct BiquadFilter16Struct *BiquadFilter16Ptr);
 void resetBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr);
 
+/*
+ * Biquad coefficient design for the state variable filter above
+ * Alpha = 2 * sin(PI * CutoffFrequency / SampleFrequency) and DampingFactor = 1 / Q.
+ * At the cutoff frequency, lowpass and highpass have a gain of Q and the bandpass has a gain of 1.
+ * The Alpha_shift8 resolution gives coarse frequency steps for low cutoff frequencies, e.g. 1 is 0.31 Hz and 2 is 0.62 Hz at 1 kHz.
+ * The constexpr functions can be used to compute the coefficients at compile time:
+ * initBiquad16(&sBiQuad, getBiquadDampingFactor_shift8(0.707), getBiquadAlpha_shift8(1000, 20));
+ */
+constexpr float getBiquadSineHelper(float aRadian) { // Taylor series, error < 1E-5 up to PI/2
+    return aRadian
+            * (1 - aRadian * aRadian / 6 * (1 - aRadian * aRadian / 20 * (1 - aRadian * aRadian / 42 * (1 - aRadian * aRadian / 72))));
+}
+constexpr float getBiquadAlpha(float aSampleFrequencyHertz, float aCutoffFrequencyHertz) {
+    return 2 * getBiquadSineHelper(3.14159265f * aCutoffFrequencyHertz / aSampleFrequencyHertz);
+}
+/*
+ * @return Nearest Alpha_shift8 value, clipped to 1 to 255
+ */
+constexpr uint8_t getBiquadAlpha_shift8(float aSampleFrequencyHertz, float aCutoffFrequencyHertz) {
+    return (getBiquadAlpha(aSampleFrequencyHertz, aCutoffFrequencyHertz) * 256 < 1.5f) ?
+            1 : ((getBiquadAlpha(aSampleFrequencyHertz, aCutoffFrequencyHertz) * 256 > 254.5f) ?
+                    255 : (uint8_t) (getBiquadAlpha(aSampleFrequencyHertz, aCutoffFrequencyHertz) * 256 + 0.5f));
+}
+/*
+ * @return Nearest DampingFactor_shift8 value. Q of 0.707 gives 362, which is a Butterworth response.
+ */
+constexpr int16_t getBiquadDampingFactor_shift8(float aQ) {
+    return (aQ < (256.0f / 32767)) ? 32767 : (int16_t) (256 / aQ + 0.5f);
+}
+
+struct BiquadDesignStruct {
+    int16_t DampingFactor_shift8;
+    uint8_t Alpha_shift8;
+    float AchievedCutoffFrequencyHertz; // for the rounded Alpha_shift8
+    float AchievedQ;                    // for the rounded DampingFactor_shift8
+    float CutoffErrorPercent;
+    float QErrorPercent;
+    uint16_t Int16DeadBand;             // Highpass values below it do not change the bandpass of the int16 filter. 128 / Alpha_shift8.
+    bool IsStable;                      // Alpha < 2 - DampingFactor, otherwise the filter will oscillate
+};
+void designBiquad(struct BiquadDesignStruct *aBiquadDesignPtr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ);
+void initBiquad16(struct BiquadFilter16Struct *BiquadFilter16Ptr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ);
+void initBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ);
+
+/*
+ * Direct form biquads y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2 with a0 = 1
+ * Coefficients can be designed with designBiquadLowpassCoefficients() etc. and are then quantized to Q14 or Q30,
+ * since b1 and a1 can be up to +/-2.
+ * The Q15 filters use int16_t values and an int32_t accumulator. The accumulator cannot overflow for input values within +/-8192,
+ * which covers all ADC values. The Q31 filters use int32_t values and an int64_t accumulator, which is slow on AVR.
+ * The output is saturated for both.
+ * Without feeding back the rounding error, the output of the Q15 filters would stick in a dead band of around 0.5 / (1 + a1 + a2)
+ * per section. For a cascade it is larger, e.g. a 4. order 20 Hz Butterworth at 1 kHz and a 50 Hz notch stayed at -47 LSB
+ * after an impulse of 1000. With error feedback, both settle to 0 like the Q31 filters.
+ * The remaining error is the quantization of the coefficients, e.g. a DC gain of 1.008 for the Butterworth above.
+ * Use the Q31 filters if this matters for cutoff frequencies far below the sample frequency. See extras/FilterBenchmark.
+ * Second order sections (SOS) are cascaded by doBiquadSOS*(). E.g. a 4. order Butterworth lowpass consists of 2 sections.
+ */
+struct BiquadCoefficientsStruct {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+};
+struct BiquadCoefficientsQ14Struct {
+    int16_t b0;
+    int16_t b1;
+    int16_t b2;
+    int16_t a1;
+    int16_t a2;
+};
+struct BiquadCoefficientsQ30Struct {
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+};
+
+struct BiquadDF1Q15Struct {
+    struct BiquadCoefficientsQ14Struct Coefficients;
+    int16_t X1; // last input
+    int16_t X2;
+    int16_t Y1; // last output
+    int16_t Y2;
+    int16_t E1; // 14 fraction bits of last output, removed by rounding
+    int16_t E2;
+};
+struct BiquadDF2TQ15Struct {
+    struct BiquadCoefficientsQ14Struct Coefficients;
+    int32_t S1_Q29; // State with 14 fraction bits
+    int32_t S2_Q29;
+};
+struct BiquadDF1Q31Struct {
+    struct BiquadCoefficientsQ30Struct Coefficients;
+    int32_t X1;
+    int32_t X2;
+    int32_t Y1;
+    int32_t Y2;
+};
+struct BiquadDF2TQ31Struct {
+    struct BiquadCoefficientsQ30Struct Coefficients;
+    int64_t S1_Q61;
+    int64_t S2_Q61;
+};
+
+void designBiquadLowpassCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aCutoffFrequencyHertz, float aQ);
+void designBiquadHighpassCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aCutoffFrequencyHertz, float aQ);
+void designBiquadNotchCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aNotchFrequencyHertz, float aQ);
+float getButterworthSectionQ(uint8_t aOrder, uint8_t aSectionIndex);
+float quantizeBiquadCoefficientsQ14(struct BiquadCoefficientsQ14Struct *aQ14CoefficientsPtr,
+        const struct BiquadCoefficientsStruct *aCoefficientsPtr);
+float quantizeBiquadCoefficientsQ30(struct BiquadCoefficientsQ30Struct *aQ30CoefficientsPtr,
+        const struct BiquadCoefficientsStruct *aCoefficientsPtr);
+
+int16_t doBiquadDF1_Q15(struct BiquadDF1Q15Struct *aBiquadPtr, int16_t aInputValue);
+int16_t doBiquadDF2T_Q15(struct BiquadDF2TQ15Struct *aBiquadPtr, int16_t aInputValue);
+int32_t doBiquadDF1_Q31(struct BiquadDF1Q31Struct *aBiquadPtr, int32_t aInputValue);
+int32_t doBiquadDF2T_Q31(struct BiquadDF2TQ31Struct *aBiquadPtr, int32_t aInputValue);
+int16_t doBiquadSOSDF1_Q15(struct BiquadDF1Q15Struct *aSectionArray, uint8_t aNumberOfSections, int16_t aInputValue);
+int16_t doBiquadSOSDF2T_Q15(struct BiquadDF2TQ15Struct *aSectionArray, uint8_t aNumberOfSections, int16_t aInputValue);
+int32_t doBiquadSOSDF1_Q31(struct BiquadDF1Q31Struct *aSectionArray, uint8_t aNumberOfSections, int32_t aInputValue);
+int32_t doBiquadSOSDF2T_Q31(struct BiquadDF2TQ31Struct *aSectionArray, uint8_t aNumberOfSections, int32_t aInputValue);
+
+/*
+ * Cascade of Stages identical EMA lowpass filters with alpha = 1 / 2^Shift. Each stage adds 6 db per octave.
+ * Supports any combination of shift and stage count.
+ * The hand coded doDoubleLowpass3_int16(), doTripleLowpass3_int16() and doDoubleLowpass4_int16() are wrappers around it.
+ * The stage updates are unrolled at compile time and all accumulators are in one array.
+ * For int16_t accumulators, the math of doLowpassShift_int16() including rounding is used.
+ * For int32_t accumulators, the math of doLowpassShift_int32_shift8() with (24,8) fixed point values is used.
+ * Usage:
+ * EMALowpassCascade<int16_t, 3, 3> sTripleLowpass3;
+ * int16_t tFiltered = sTripleLowpass3.update(aInputValue);
+ */
+template<typename Acc, uint8_t Shift, uint8_t Index, uint8_t Remaining>
+struct EMALowpassCascadeStages {
+    static inline __attribute__((always_inline)) void update(Acc *aAccumulators, Acc aInput) {
+        if (sizeof(Acc) > sizeof(int16_t)) {
+            aAccumulators[Index] += (aInput - aAccumulators[Index]) >> Shift;
+        } else {
+            aAccumulators[Index] += ((aInput - aAccumulators[Index]) + (1 << (Shift - 1))) >> Shift;
+        }
+        EMALowpassCascadeStages<Acc, Shift, Index + 1, Remaining - 1>::update(aAccumulators, aAccumulators[Index]);
+    }
+};
+template<typename Acc, uint8_t Shift, uint8_t Index>
+struct EMALowpassCascadeStages<Acc, Shift, Index, 0> {
+    static inline __attribute__((always_inline)) void update(Acc *aAccumulators __attribute__((unused)),
+            Acc aInput __attribute__((unused))) {
+    }
+};
+
+template<typename Acc, uint8_t Shift, uint8_t Stages>
+struct EMALowpassCascade {
+    static_assert(sizeof(Acc) == sizeof(int16_t) || sizeof(Acc) == sizeof(int32_t), "Accumulator type must be int16_t or int32_t");
+    static_assert(Shift >= 1 && Shift <= 8, "Shift must be between 1 and 8");
+    static_assert(Stages >= 1, "At least one stage is required");
+    static const uint8_t FractionBits = (sizeof(Acc) > sizeof(int16_t)) ? 8 : 0;
+
+    Acc Accumulators[Stages]; // Accumulators[0] is the first lowpass, Accumulators[Stages - 1] the output
+
+    void reset(int16_t aValue = 0) {
+        for (uint_fast8_t i = 0; i < Stages; ++i) {
+            Accumulators[i] = (Acc) aValue << FractionBits;
+        }
+    }
+    /*
+     * @return Value of the last stage
+     */
+    int16_t update(int16_t aInputValue) {
+        EMALowpassCascadeStages<Acc, Shift, 0, Stages>::update(Accumulators, (Acc) aInputValue << FractionBits);
+        return Accumulators[Stages - 1] >> FractionBits;
+    }
+    /*
+     * Processes a buffer of samples. The accumulators are kept in local variables during the loop.
+     * aOutputValues may be identical to aInputValues.
+     */
+    void updateBlock(const int16_t *aInputValues, int16_t *aOutputValues, uint16_t aNumberOfValues) {
+        Acc tAccumulators[Stages];
+        for (uint_fast8_t i = 0; i < Stages; ++i) {
+            tAccumulators[i] = Accumulators[i];
+        }
+        for (uint16_t i = 0; i < aNumberOfValues; ++i) {
+            EMALowpassCascadeStages<Acc, Shift, 0, Stages>::update(tAccumulators, (Acc) aInputValues[i] << FractionBits);
+            aOutputValues[i] = tAccumulators[Stages - 1] >> FractionBits;
+        }
+        for (uint_fast8_t i = 0; i < Stages; ++i) {
+            Accumulators[i] = tAccumulators[i];
+        }
+    }
+    /*
+     * @param aStage 0 for the simple lowpass, 1 for the double lowpass etc.
+     */
+    int16_t getValue(uint8_t aStage = Stages - 1) {
+        return Accumulators[aStage] >> FractionBits;
+    }
+};
+
+/*
+ * Moving average over the last 2^Log2WindowSize values. The update is O(1) by using a running sum over a ring buffer.
+ * In contrast to the EMA filters, a single spike is completely removed after WindowSize samples.
+ * Memory per instance is 2 * WindowSize + 5 bytes, e.g. 37 bytes for a window of 16.
+ * Usage:
+ * MovingAverageFilter<4> sMovingAverage16;
+ * int16_t tFiltered = sMovingAverage16.update(aInputValue);
+ */
+template<uint8_t Log2WindowSize>
+struct MovingAverageFilter {
+    static_assert(Log2WindowSize >= 1 && Log2WindowSize <= 8, "Log2WindowSize must be between 1 and 8");
+    static const uint16_t WindowSize = 1 << Log2WindowSize;
+
+    int16_t Values[WindowSize]; // Ring buffer, Values[Index] is the oldest value
+    int32_t Sum;
+    uint8_t Index;
+
+    void reset(int16_t aValue = 0) {
+        for (uint16_t i = 0; i < WindowSize; ++i) {
+            Values[i] = aValue;
+        }
+        Sum = (int32_t) aValue << Log2WindowSize;
+        Index = 0;
+    }
+    int16_t update(int16_t aInputValue) {
+        Sum += aInputValue - Values[Index];
+        Values[Index] = aInputValue;
+        Index = (Index + 1) & (WindowSize - 1);
+        return Sum >> Log2WindowSize;
+    }
+    int16_t getValue() {
+        return Sum >> Log2WindowSize;
+    }
+};
+
+/*
+ * Median of 3, 5 or 7 values with optimal sorting networks. Rejects single (3), double (5) or triple (7) spikes.
+ * getMedianOf5() and getMedianOf7() reorder the content of the array.
+ */
+int16_t getMedianOf3(int16_t aValue0, int16_t aValue1, int16_t aValue2);
+int16_t getMedianOf5(int16_t *aValues);
+int16_t getMedianOf7(int16_t *aValues);
+
+/*
+ * Median of the last WindowSize values. WindowSize must be odd.
+ * For a WindowSize of 3, 5 or 7 the sorting networks above are used.
+ * For larger windows, a sorted copy of the window is maintained, in which the oldest value is replaced by the new one.
+ * This requires a binary search and a move of at most WindowSize values, but no sorting.
+ * Memory per instance is 2 * WindowSize + 3 bytes for a window of 3, 5 or 7 and 4 * WindowSize + 1 bytes for larger windows.
+ * Usage:
+ * MedianFilter<5> sMedian5;
+ * int16_t tFiltered = sMedian5.update(aInputValue);
+ */
+template<uint8_t WindowSize>
+struct MedianFilter {
+    static_assert((WindowSize & 1) && WindowSize >= 3 && WindowSize <= 255, "WindowSize must be odd and between 3 and 255");
+    static const bool UseSortingNetwork = (WindowSize <= 7);
+    static const uint8_t SortingNetworkSize = UseSortingNetwork ? WindowSize : 1;
+
+    int16_t Values[WindowSize]; // Ring buffer, Values[Index] is the oldest value
+    int16_t SortedValues[UseSortingNetwork ? 1 : WindowSize];
+    uint8_t Index;
+
+    void reset(int16_t aValue = 0) {
+        for (uint_fast8_t i = 0; i < WindowSize; ++i) {
+            Values[i] = aValue;
+            if (!UseSortingNetwork) {
+                SortedValues[i] = aValue;
+            }
+        }
+        Index = 0;
+    }
+
+    int16_t update(int16_t aInputValue) {
+        int16_t tOldestValue = Values[Index];
+        Values[Index] = aInputValue;
+        Index++;
+        if (Index >= WindowSize) {
+            Index = 0;
+        }
+        if (UseSortingNetwork) {
+            return getValue();
+        }
+
+        /*
+         * Find the position of the oldest value and move the values between it and the new position by one
+         */
+        uint8_t tLow = 0;
+        uint8_t tHigh = WindowSize - 1;
+        while (tLow < tHigh) {
+            uint8_t tMiddle = (tLow + tHigh) / 2;
+            if (SortedValues[tMiddle] < tOldestValue) {
+                tLow = tMiddle + 1;
+            } else {
+                tHigh = tMiddle;
+            }
+        }
+        uint8_t tPosition = tLow;
+        if (aInputValue > tOldestValue) {
+            while (tPosition < WindowSize - 1 && SortedValues[tPosition + 1] < aInputValue) {
+                SortedValues[tPosition] = SortedValues[tPosition + 1];
+                tPosition++;
+            }
+        } else {
+            while (tPosition > 0 && SortedValues[tPosition - 1] > aInputValue) {
+                SortedValues[tPosition] = SortedValues[tPosition - 1];
+                tPosition--;
+            }
+        }
+        SortedValues[tPosition] = aInputValue;
+        return SortedValues[WindowSize / 2];
+    }
+
+    int16_t getValue() {
+        if (WindowSize == 3) {
+            return getMedianOf3(Values[0], Values[1], Values[2 % WindowSize]);
+        }
+        if (UseSortingNetwork) {
+            int16_t tValues[7];
+            for (uint_fast8_t i = 0; i < SortingNetworkSize; ++i) {
+                tValues[i] = Values[i];
+            }
+            return (WindowSize == 5) ? getMedianOf5(tValues) : getMedianOf7(tValues);
+        }
+        return SortedValues[WindowSize / 2];
+    }
+};
+
 #define VERSION_SIMPLE_EMA_FILTERS "2.0.0"
 #define VERSION_SIMPLE_EMA_FILTERS_MAJOR 2
 #define VERSION_SIMPLE_EMA_FILTERS_MINOR 0
@@ -114,29 +461,87 @@ void resetBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr);
 
 #define PRINT_ALL_FILTERS           0xFFFFFFFF
 
-extern int16_t sInputValueForPrint;
+/*
+ * Filters required for the print mask bits. Lowpass 1, 3, 4 and 5 are also used for high pass, band pass and band stop.
+ */
+#define FILTER_BANK_LP_1_MASK   (PRINT_LP_1 | PRINT_HIGH_PASS_1_16 | PRINT_BAND_PASS_1_3 | PRINT_BAND_PASS_1_5)
+#define FILTER_BANK_LP_3_MASK   (PRINT_LP_3 | PRINT_DOUBLE_LP_3 | PRINT_TRIPLE_LP_3 | PRINT_HIGH_PASS_3_16 | PRINT_BAND_PASS_1_3 \
+                                | PRINT_BAND_PASS_3_4 | PRINT_BAND_PASS_3_5 | PRINT_BAND_STOP_3_4)
+#define FILTER_BANK_LP_4_MASK   (PRINT_LP_4 | PRINT_DOUBLE_LP_4 | PRINT_BAND_PASS_3_4 | PRINT_BAND_STOP_3_4)
+#define FILTER_BANK_LP_5_MASK   (PRINT_LP_5 | PRINT_BAND_PASS_1_5 | PRINT_BAND_PASS_3_5)
+
+/*
+ * State of the demo filters for NumberOfChannels independent signals.
+ * Each filter state is an array over all channels (struct of arrays), so one filter is computed for all channels in one loop.
+ * Only the filters required for the mask given to doStep() are computed.
+ * Usage:
+ * EMAFilterBank<8> sFilterBank;
+ * sFilterBank.doStep(tADCValues, PRINT_LOW_PASS_1_3_5_8);
+ * sFilterBank.printResults(tChannel, PRINT_LOW_PASS_1_3_5_8);
+ */
+template<uint8_t NumberOfChannels>
+struct EMAFilterBank {
+    EMAFilterBank() {
+        reset();
+    }
+    void reset();
+    void doStep(const int16_t *aInputValues, uint32_t aFilterMask = PRINT_ALL_FILTERS);
+    void printResults(uint8_t aChannel, uint32_t aPrintMask = PRINT_ALL_FILTERS);
+
+    int16_t InputValue[NumberOfChannels];   // Last input value for print
+
+    int16_t Lowpass1[NumberOfChannels];
+    int16_t Lowpass2[NumberOfChannels];
+    int16_t Lowpass3[NumberOfChannels];
+    int16_t Lowpass4[NumberOfChannels];
+    int16_t Lowpass5[NumberOfChannels];
+
+    int16_t DoubleLowpass3[NumberOfChannels];
+    int16_t DoubleLowpass4[NumberOfChannels];
+    int16_t DoubleLowpass5[NumberOfChannels];
+
+    int16_t TripleLowpass3[NumberOfChannels];
+
+    int32_t Lowpass3_int32_shift8[NumberOfChannels];
+    int32_t Lowpass5_int32_shift8[NumberOfChannels];
+    int32_t Lowpass8_int32_shift8[NumberOfChannels];
+
+    float Lowpass5_float[NumberOfChannels];
+    float Lowpass8_float[NumberOfChannels];
+
+    struct BiquadFilter16Struct BiQuad_int16[NumberOfChannels];
+    struct BiquadFilter32Struct BiQuad_int32[NumberOfChannels];
+};
+
+/*
+ * The single channel demo functions below use channel 0 of sFilterBank.
+ * The former global filter variables are now references to it.
+ */
+extern EMAFilterBank<1> sFilterBank;
+
+extern int16_t &sInputValueForPrint;
 
-extern int16_t sLowpass1;
-extern int16_t sLowpass2;
-extern int16_t sLowpass3;
-extern int16_t sLowpass4;
-extern int16_t sLowpass5;
+extern int16_t &sLowpass1;
+extern int16_t &sLowpass2;
+extern int16_t &sLowpass3;
+extern int16_t &sLowpass4;
+extern int16_t &sLowpass5;
 
-extern int16_t sDoubleLowpass3;
-extern int16_t sDoubleLowpass4;
-extern int16_t sDoubleLowpass5;
+extern int16_t &sDoubleLowpass3;
+extern int16_t &sDoubleLowpass4;
+extern int16_t &sDoubleLowpass5;
 
-extern int16_t sTripleLowpass3;
+extern int16_t &sTripleLowpass3;
 
-extern int32_t sLowpass3_int32_shift8;
-extern int32_t sLowpass5_int32_shift8;
-extern int32_t sLowpass8_int32_shift8;
+extern int32_t &sLowpass3_int32_shift8;
+extern int32_t &sLowpass5_int32_shift8;
+extern int32_t &sLowpass8_int32_shift8;
 
-extern float sLowpass5_float;
-extern float sLowpass8_float;
+extern float &sLowpass5_float;
+extern float &sLowpass8_float;
 
-extern struct BiquadFilter16Struct sBiQuad_int16;
-extern struct BiquadFilter32Struct sBiQuad_int32;
+extern struct BiquadFilter16Struct &sBiQuad_int16;
+extern struct BiquadFilter32Struct &sBiQuad_int32;
 
 void resetFilters();
 void doFiltersTimingTest(int16_t aInputValue);
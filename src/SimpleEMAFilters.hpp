@@ -74,10 +74,16 @@
 #ifndef _SIMPLE_EMA_FILTERS_HPP
 #define _SIMPLE_EMA_FILTERS_HPP
 
+#if defined(USE_ADC_SIMULATION)
+#include "ADCSimulation.hpp" // Host backend, e.g. for extras/FilterBenchmark
+#else
 #include <Arduino.h>
+#endif
 
 #include "SimpleEMAFilters.h"
+#if !defined(USE_ADC_SIMULATION)
 #include "digitalWriteFast.h"
+#endif
 
 //#define MEASURE_TIMING
 #if !defined(TIMING_OUT_PIN)
@@ -89,36 +95,55 @@
 #endif
 
 /*
- * Storage for implementation of some fixed fast LOWPASS filters
+ * Storage for the demo functions
  */
-int16_t sLowpass1;
-int16_t sLowpass2;
-int16_t sLowpass3;
-int16_t sLowpass4;
-int16_t sLowpass5;
-int16_t sLowpass6;
-int16_t sDoubleLowpass3;
-int16_t sDoubleLowpass4;
-int16_t sDoubleLowpass5;
-int16_t sTripleLowpass3;
+EMAFilterBank<1> sFilterBank;
+
+int16_t &sLowpass1 = sFilterBank.Lowpass1[0];
+int16_t &sLowpass2 = sFilterBank.Lowpass2[0];
+int16_t &sLowpass3 = sFilterBank.Lowpass3[0];
+int16_t &sLowpass4 = sFilterBank.Lowpass4[0];
+int16_t &sLowpass5 = sFilterBank.Lowpass5[0];
+int16_t &sDoubleLowpass3 = sFilterBank.DoubleLowpass3[0];
+int16_t &sDoubleLowpass4 = sFilterBank.DoubleLowpass4[0];
+int16_t &sDoubleLowpass5 = sFilterBank.DoubleLowpass5[0];
+int16_t &sTripleLowpass3 = sFilterBank.TripleLowpass3[0];
 // only required if we must deal with small values or high exponents (> 32)
-int32_t sLowpass2_int32_shift8;
-int32_t sLowpass3_int32_shift8;
-int32_t sLowpass5_int32_shift8;
-int32_t sLowpass8_int32_shift8; // The low pass value is in the upper word, the lower word holds the fraction
-float sLowpass5_float;
-float sLowpass8_float;
+int32_t &sLowpass3_int32_shift8 = sFilterBank.Lowpass3_int32_shift8[0];
+int32_t &sLowpass5_int32_shift8 = sFilterBank.Lowpass5_int32_shift8[0];
+int32_t &sLowpass8_int32_shift8 = sFilterBank.Lowpass8_int32_shift8[0]; // The low pass value is in the upper word, the lower word holds the fraction
+float &sLowpass5_float = sFilterBank.Lowpass5_float[0];
+float &sLowpass8_float = sFilterBank.Lowpass8_float[0];
 
 /*
  * Biquad
  */
-struct BiquadFilter16Struct sBiQuad_int16;
-struct BiquadFilter32Struct sBiQuad_int32;
+struct BiquadFilter16Struct &sBiQuad_int16 = sFilterBank.BiQuad_int16[0];
+struct BiquadFilter32Struct &sBiQuad_int32 = sFilterBank.BiQuad_int32[0];
+
+/*
+ * Only used by doFiltersTimingTest()
+ */
+int16_t sLowpass6;
+int32_t sLowpass2_int32_shift8;
+struct BiquadDF1Q15Struct sBiquadDF1_Q15[2]; // 4. order Butterworth lowpass
+struct BiquadDF2TQ15Struct sBiquadDF2T_Q15;   // 50 Hz notch
+struct BiquadDF1Q31Struct sBiquadDF1_Q31;
+struct BiquadDF2TQ31Struct sBiquadDF2T_Q31;
+MovingAverageFilter<4> sMovingAverage16;
+MedianFilter<5> sMedian5;
+MedianFilter<15> sMedian15;
+
+/*
+ * Only for timing comparison of the cascade template with the hand coded double and triple lowpass functions
+ */
+EMALowpassCascade<int16_t, 3, 3> sTripleLowpass3Cascade;
+EMALowpassCascade<int32_t, 5, 2> sDoubleLowpass5Cascade_int32;
 
 /*
  * Variables for filter demo
  */
-int16_t sInputValueForPrint;
+int16_t &sInputValueForPrint = sFilterBank.InputValue[0];
 
 uint32_t FilterSelectionArray[8] {
 PRINT_SIGNIFICANT_FILTERS, PRINT_ALL_LOW_PASS, PRINT_LOW_HIGH_PASS, PRINT_BAND_PASS_AND_BAND_STOP, PRINT_LOW_PASS_1_3_5_8,
@@ -171,6 +196,33 @@ void doLowpass_int16(int16_t *aLowpassAccumulator_int16, int16_t aInputValue, ui
             >> 8;
 }
 
+/*
+ * Block variants of doLowpassShift_int16() and doLowpass_int16() for buffered samples, e.g. from the ADCUtils sampler.
+ * The accumulator is loaded only once, which saves the pointer access of the single value functions for each sample.
+ * @param aOutputValues Can be identical to aInputValues for in place filtering
+ */
+void doLowpassShift_int16_block(int16_t *aLowpassAccumulator_int16, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aShiftValue) {
+    int16_t tLowpassAccumulator = *aLowpassAccumulator_int16;
+    int16_t tRoundingValue = 1 << (aShiftValue - 1);
+    for (uint16_t i = 0; i < aNumberOfValues; ++i) {
+        tLowpassAccumulator += ((aInputValues[i] - tLowpassAccumulator) + tRoundingValue) >> aShiftValue;
+        aOutputValues[i] = tLowpassAccumulator;
+    }
+    *aLowpassAccumulator_int16 = tLowpassAccumulator;
+}
+
+void doLowpass_int16_block(int16_t *aLowpassAccumulator_int16, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aAlpha_shift8) {
+    int16_t tLowpassAccumulator = *aLowpassAccumulator_int16;
+    uint8_t tRoundingValue = aAlpha_shift8 / 2;
+    for (uint16_t i = 0; i < aNumberOfValues; ++i) {
+        tLowpassAccumulator += (((int32_t) (aInputValues[i] - tLowpassAccumulator) * aAlpha_shift8) + tRoundingValue) >> 8;
+        aOutputValues[i] = tLowpassAccumulator;
+    }
+    *aLowpassAccumulator_int16 = tLowpassAccumulator;
+}
+
 /*
  * Has 12 db per octave and computes lowpass and double lowpass
  */
@@ -193,6 +245,109 @@ void doTripleLowpass_int16(int16_t *aLowpassAccumulator_int16, int16_t *aDoubleL
             + (1 << (aShiftValue - 1))) >> aShiftValue;
 }
 
+/*********************************************************************************************************
+ * AVR assembler kernels for the 32 bit filters
+ * avr-gcc uses the generic __mulsi3 32 x 32 bit multiplication for the int32 x uint8 and int32 x int16 products.
+ * These kernels use only the required 8 x 8 bit hardware multiplications and byte moves for the shift by 8.
+ * Define DO_NOT_USE_FILTER_ASSEMBLER_KERNELS to use the C versions doLowpass_int32_shift8_C() etc. instead.
+ * The results are identical to the C versions, as long as the C versions do not overflow.
+ * This and the clock cycles are checked on the host by extras/FilterKernelCheck.
+ *********************************************************************************************************/
+#if defined(__AVR_ARCH__) && defined(__AVR_HAVE_MUL__) && !defined(DO_NOT_USE_FILTER_ASSEMBLER_KERNELS)
+#define FILTER_ASSEMBLER_KERNELS_ARE_AVAILABLE
+/*
+ * @return (aValue * aFactor) >> 8 computed with a 40 bit intermediate. 21 clock cycles.
+ */
+__attribute__((always_inline)) inline int32_t multiplyInt32ByUint8Shift8(int32_t aValue, uint8_t aFactor) {
+    int32_t tResult;
+    __asm__ (
+            "mul  %A1, %2"      "\n\t" // byte 0 of product is discarded by >> 8
+            "mov  %A0, r1"      "\n\t"
+            "clr  %B0"          "\n\t"
+            "clr  %C0"          "\n\t"
+            "clr  %D0"          "\n\t"
+            "mul  %B1, %2"      "\n\t"
+            "add  %A0, r0"      "\n\t"
+            "adc  %B0, r1"      "\n\t" // high byte of a 8 x 8 product is <= 0xFE, so no carry to next byte
+            "mul  %C1, %2"      "\n\t"
+            "add  %B0, r0"      "\n\t"
+            "adc  %C0, r1"      "\n\t"
+            "mul  %D1, %2"      "\n\t"
+            "add  %C0, r0"      "\n\t"
+            "adc  %D0, r1"      "\n\t"
+            "sbrc %D1, 7"       "\n\t" // aValue was multiplied as unsigned, so subtract aFactor << 32 if aValue is negative
+            "sub  %D0, %2"      "\n\t"
+            "clr  __zero_reg__" "\n\t"
+            : "=&r" (tResult)
+            : "r" (aValue), "r" (aFactor)
+    );
+    return tResult;
+}
+
+/*
+ * @return lower 32 bit of aValue * aFactor. 21 to 23 clock cycles.
+ */
+__attribute__((always_inline)) inline int32_t multiplyInt32ByInt8(int32_t aValue, int8_t aFactor) {
+    int32_t tResult;
+    __asm__ (
+            "mul  %A1, %2"      "\n\t"
+            "mov  %A0, r0"      "\n\t"
+            "mov  %B0, r1"      "\n\t"
+            "clr  %C0"          "\n\t"
+            "clr  %D0"          "\n\t"
+            "mul  %B1, %2"      "\n\t"
+            "add  %B0, r0"      "\n\t"
+            "adc  %C0, r1"      "\n\t"
+            "mul  %C1, %2"      "\n\t"
+            "add  %C0, r0"      "\n\t"
+            "adc  %D0, r1"      "\n\t"
+            "mul  %D1, %2"      "\n\t"
+            "add  %D0, r0"      "\n\t"
+            "sbrs %2, 7"        "\n\t" // aFactor was multiplied as unsigned, so subtract aValue << 8 if aFactor is negative
+            "rjmp 1f"           "\n\t"
+            "sub  %B0, %A1"     "\n\t"
+            "sbc  %C0, %B1"     "\n\t"
+            "sbc  %D0, %C1"     "\n\t"
+            "1:"                "\n\t"
+            "clr  __zero_reg__" "\n\t"
+            : "=&r" (tResult)
+            : "r" (aValue), "r" (aFactor)
+    );
+    return tResult;
+}
+
+/*
+ * (aValue * aFactor) >> 8 is split into (aValue * LowByte) >> 8 + aValue * HighByte, which is exact,
+ * because aValue * HighByte * 256 has no bits below bit 8.
+ */
+__attribute__((always_inline)) inline int32_t multiplyInt32ByInt16Shift8(int32_t aValue, int16_t aFactor) {
+    int32_t tResult = multiplyInt32ByUint8Shift8(aValue, (uint8_t) aFactor);
+    int8_t tFactorHighByte = aFactor >> 8;
+    if (tFactorHighByte != 0) {
+        tResult += multiplyInt32ByInt8(aValue, tFactorHighByte);
+    }
+    return tResult;
+}
+
+/*
+ * @return aValue >> 8 with byte moves and without a shift loop. 6 clock cycles.
+ */
+__attribute__((always_inline)) inline int32_t shiftRightInt32By8(int32_t aValue) {
+    int32_t tResult;
+    __asm__ (
+            "mov  %A0, %B1"     "\n\t"
+            "mov  %B0, %C1"     "\n\t"
+            "mov  %C0, %D1"     "\n\t"
+            "mov  %D0, %D1"     "\n\t"
+            "lsl  %D0"          "\n\t" // sign to carry
+            "sbc  %D0, %D0"     "\n\t" // 0x00 or 0xFF
+            : "=&r" (tResult)
+            : "r" (aValue)
+    );
+    return tResult;
+}
+#endif // defined(FILTER_ASSEMBLER_KERNELS_ARE_AVAILABLE)
+
 /******************************************************
  * int32 functions with (24,8) fixed point accumulator
  ******************************************************/
@@ -220,8 +375,44 @@ void doLowpassShift_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int1
 __attribute__((always_inline)) inline
 #endif
 void doLowpass_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int16_t aInputValue, uint8_t aAlpha_shift8) {
+#if defined(FILTER_ASSEMBLER_KERNELS_ARE_AVAILABLE)
+    *aLowpassAccumulator_int32_shift8 += multiplyInt32ByUint8Shift8(
+            ((int32_t) aInputValue << 8) - *aLowpassAccumulator_int32_shift8, aAlpha_shift8);
+#else
     *aLowpassAccumulator_int32_shift8 += (((((int32_t) aInputValue << 8) - *aLowpassAccumulator_int32_shift8)) * aAlpha_shift8)
             >> 8;
+#endif
+}
+/*
+ * C version as reference for the assembler kernel
+ */
+void doLowpass_int32_shift8_C(int32_t *aLowpassAccumulator_int32_shift8, int16_t aInputValue, uint8_t aAlpha_shift8) {
+    *aLowpassAccumulator_int32_shift8 += (((((int32_t) aInputValue << 8) - *aLowpassAccumulator_int32_shift8)) * aAlpha_shift8)
+            >> 8;
+}
+
+/*
+ * Block variants of doLowpassShift_int32_shift8() and doLowpass_int32_shift8(). Output values are the integer part of the accumulator.
+ * @param aOutputValues Can be identical to aInputValues for in place filtering
+ */
+void doLowpassShift_int32_shift8_block(int32_t *aLowpassAccumulator_int32_shift8, const int16_t *aInputValues,
+        int16_t *aOutputValues, uint16_t aNumberOfValues, uint8_t aShiftValue) {
+    int32_t tLowpassAccumulator = *aLowpassAccumulator_int32_shift8;
+    for (uint16_t i = 0; i < aNumberOfValues; ++i) {
+        tLowpassAccumulator += (((int32_t) aInputValues[i] << 8) - tLowpassAccumulator) >> aShiftValue;
+        aOutputValues[i] = tLowpassAccumulator >> 8;
+    }
+    *aLowpassAccumulator_int32_shift8 = tLowpassAccumulator;
+}
+
+void doLowpass_int32_shift8_block(int32_t *aLowpassAccumulator_int32_shift8, const int16_t *aInputValues, int16_t *aOutputValues,
+        uint16_t aNumberOfValues, uint8_t aAlpha_shift8) {
+    int32_t tLowpassAccumulator = *aLowpassAccumulator_int32_shift8;
+    for (uint16_t i = 0; i < aNumberOfValues; ++i) {
+        tLowpassAccumulator += ((((int32_t) aInputValues[i] << 8) - tLowpassAccumulator) * aAlpha_shift8) >> 8;
+        aOutputValues[i] = tLowpassAccumulator >> 8;
+    }
+    *aLowpassAccumulator_int32_shift8 = tLowpassAccumulator;
 }
 
 void doDoubleLowpass_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int32_t *aDoubleLowpassAccumulator_int32_shift8,
@@ -302,19 +493,24 @@ void doLowpass3_int16(int16_t *aLowpassAccumulator_int16, int16_t aInputValue) {
 }
 /*
  * Double LOWPASS has 12 db per octave
+ * The fixed shift cascades are wrappers around EMALowpassCascadeStages, which computes the identical values
  */
 void doDoubleLowpass3_int16(int16_t *aLowpassAccumulator_int16, int16_t *aDoubleLowpassAccumulator_int16, int16_t aInputValue) {
-    *aLowpassAccumulator_int16 += ((aInputValue - *aLowpassAccumulator_int16) + (1 << 2)) >> 3;
-    *aDoubleLowpassAccumulator_int16 += ((*aLowpassAccumulator_int16 - *aDoubleLowpassAccumulator_int16) + (1 << 2)) >> 3;
+    int16_t tAccumulators[2] = { *aLowpassAccumulator_int16, *aDoubleLowpassAccumulator_int16 };
+    EMALowpassCascadeStages<int16_t, 3, 0, 2>::update(tAccumulators, aInputValue);
+    *aLowpassAccumulator_int16 = tAccumulators[0];
+    *aDoubleLowpassAccumulator_int16 = tAccumulators[1];
 }
 /*
  * Triple LOWPASS has 18 db per octave
  */
 void doTripleLowpass3_int16(int16_t *aLowpassAccumulator_int16, int16_t *aDoubleLowpassAccumulator_int16,
         int16_t *aTripleLowpassAccumulator_int16, int16_t aInputValue) {
-    *aLowpassAccumulator_int16 += ((aInputValue - *aLowpassAccumulator_int16) + (1 << 2)) >> 3;
-    *aDoubleLowpassAccumulator_int16 += ((*aLowpassAccumulator_int16 - *aDoubleLowpassAccumulator_int16) + (1 << 2)) >> 3;
-    *aTripleLowpassAccumulator_int16 += ((*aDoubleLowpassAccumulator_int16 - *aTripleLowpassAccumulator_int16) + (1 << 2)) >> 3;
+    int16_t tAccumulators[3] = { *aLowpassAccumulator_int16, *aDoubleLowpassAccumulator_int16, *aTripleLowpassAccumulator_int16 };
+    EMALowpassCascadeStages<int16_t, 3, 0, 3>::update(tAccumulators, aInputValue);
+    *aLowpassAccumulator_int16 = tAccumulators[0];
+    *aDoubleLowpassAccumulator_int16 = tAccumulators[1];
+    *aTripleLowpassAccumulator_int16 = tAccumulators[2];
 }
 // int32 functions with (24,8) fixed point accumulator
 void doLowpass3_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int16_t aInputValue) {
@@ -326,8 +522,10 @@ void doLowpass4_int16(int16_t *aLowpassAccumulator_int16, int16_t aInputValue) {
     *aLowpassAccumulator_int16 += ((aInputValue - *aLowpassAccumulator_int16) + (1 << 3)) >> 4;
 }
 void doDoubleLowpass4_int16(int16_t *aLowpassAccumulator_int16, int16_t *aDoubleLowpassAccumulator_int16, int16_t aInputValue) {
-    *aLowpassAccumulator_int16 += ((aInputValue - *aLowpassAccumulator_int16) + (1 << 3)) >> 4;
-    *aDoubleLowpassAccumulator_int16 += ((*aLowpassAccumulator_int16 - *aDoubleLowpassAccumulator_int16) + (1 << 3)) >> 4;
+    int16_t tAccumulators[2] = { *aLowpassAccumulator_int16, *aDoubleLowpassAccumulator_int16 };
+    EMALowpassCascadeStages<int16_t, 4, 0, 2>::update(tAccumulators, aInputValue);
+    *aLowpassAccumulator_int16 = tAccumulators[0];
+    *aDoubleLowpassAccumulator_int16 = tAccumulators[1];
 }
 
 // alpha = 1/32, cutoff frequency 5.13 Hz @1kHz
@@ -346,6 +544,13 @@ void doLowpass8_int32_shift8(int32_t *aLowpassAccumulator_int32_shift8, int16_t
     *aLowpassAccumulator_int32_shift8 += ((((int32_t) aInputValue << 8) - *aLowpassAccumulator_int32_shift8)) >> 8;
 }
 void doLowpass8_int32_shift16(int32_t *aLowpassAccumulator_int32_shift16, int16_t aInputValue) {
+#if defined(FILTER_ASSEMBLER_KERNELS_ARE_AVAILABLE)
+    *aLowpassAccumulator_int32_shift16 += shiftRightInt32By8(((int32_t) aInputValue << 16) - *aLowpassAccumulator_int32_shift16);
+#else
+    *aLowpassAccumulator_int32_shift16 += ((((int32_t) aInputValue << 16) - *aLowpassAccumulator_int32_shift16)) >> 8;
+#endif
+}
+void doLowpass8_int32_shift16_C(int32_t *aLowpassAccumulator_int32_shift16, int16_t aInputValue) {
     *aLowpassAccumulator_int32_shift16 += ((((int32_t) aInputValue << 16) - *aLowpassAccumulator_int32_shift16)) >> 8;
 }
 void doLowpass8_float(float *aLowpassAccumulator_float, int16_t aInputValue) {
@@ -372,6 +577,29 @@ void doBiquad_int16(struct BiquadFilter16Struct *BiquadFilter16Ptr, int16_t aInp
 __attribute__((always_inline)) inline
 #endif
 void doBiquad_int32(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aInputValue) {
+#if defined(FILTER_ASSEMBLER_KERNELS_ARE_AVAILABLE)
+    int32_t tBandpass_shift8 = BiquadFilter32Ptr->BiQuadBandpass_shift8;
+    int32_t tHighpass_shift8 = ((int32_t) aInputValue << 8)
+            - multiplyInt32ByInt16Shift8(tBandpass_shift8, BiquadFilter32Ptr->DampingFactor_shift8)
+            - BiquadFilter32Ptr->BiQuadLowpass_shift8; // HP = Input - (BP * DampingCoefficient) - LP
+    BiquadFilter32Ptr->BiQuadHighpass_shift8 = tHighpass_shift8;
+    tBandpass_shift8 += multiplyInt32ByUint8Shift8(tHighpass_shift8, BiquadFilter32Ptr->Alpha_shift8); // BP = BP + (HP * FrequencyCoefficient)
+    BiquadFilter32Ptr->BiQuadBandpass_shift8 = tBandpass_shift8;
+    BiquadFilter32Ptr->BiQuadLowpass_shift8 += multiplyInt32ByUint8Shift8(tBandpass_shift8, BiquadFilter32Ptr->Alpha_shift8); // LP = LP + (BP * FrequencyCoefficient)
+#else
+    BiquadFilter32Ptr->BiQuadHighpass_shift8 = ((int32_t) aInputValue << 8)
+            - ((BiquadFilter32Ptr->BiQuadBandpass_shift8 * BiquadFilter32Ptr->DampingFactor_shift8) >> 8)
+            - BiquadFilter32Ptr->BiQuadLowpass_shift8; // HP = Input - (BP * DampingCoefficient) - LP
+    BiquadFilter32Ptr->BiQuadBandpass_shift8 = BiquadFilter32Ptr->BiQuadBandpass_shift8
+            + ((BiquadFilter32Ptr->BiQuadHighpass_shift8 * BiquadFilter32Ptr->Alpha_shift8) >> 8); // BP = BP + (HP * FrequencyCoefficient)
+    BiquadFilter32Ptr->BiQuadLowpass_shift8 = BiquadFilter32Ptr->BiQuadLowpass_shift8
+            + ((BiquadFilter32Ptr->BiQuadBandpass_shift8 * BiquadFilter32Ptr->Alpha_shift8) >> 8); // LP = LP + (BP * FrequencyCoefficient)
+#endif
+}
+/*
+ * C version as reference for the assembler kernel
+ */
+void doBiquad_int32_C(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aInputValue) {
     BiquadFilter32Ptr->BiQuadHighpass_shift8 = ((int32_t) aInputValue << 8)
             - ((BiquadFilter32Ptr->BiQuadBandpass_shift8 * BiquadFilter32Ptr->DampingFactor_shift8) >> 8)
             - BiquadFilter32Ptr->BiQuadLowpass_shift8; // HP = Input - (BP * DampingCoefficient) - LP
@@ -396,6 +624,34 @@ void initBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr, int16_t aDampi
     BiquadFilter32Ptr->Alpha_shift8 = aAlpha_shift8;
 }
 
+/*
+ * Runtime variant of the coefficient design, e.g. for retuning.
+ * Also computes the frequency and Q of the rounded coefficients and the dead band of the int16 filter.
+ * If the dead band is not much smaller than the expected signal changes, use the int32 filter.
+ */
+void designBiquad(struct BiquadDesignStruct *aBiquadDesignPtr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ) {
+    uint8_t tAlpha_shift8 = getBiquadAlpha_shift8(aSampleFrequencyHertz, aCutoffFrequencyHertz);
+    int16_t tDampingFactor_shift8 = getBiquadDampingFactor_shift8(aQ);
+    aBiquadDesignPtr->Alpha_shift8 = tAlpha_shift8;
+    aBiquadDesignPtr->DampingFactor_shift8 = tDampingFactor_shift8;
+    // Alpha / 2 = sin(PI * CutoffFrequency / SampleFrequency)
+    aBiquadDesignPtr->AchievedCutoffFrequencyHertz = asin(tAlpha_shift8 / 512.0) * aSampleFrequencyHertz / PI;
+    aBiquadDesignPtr->AchievedQ = 256.0 / tDampingFactor_shift8;
+    aBiquadDesignPtr->CutoffErrorPercent = ((aBiquadDesignPtr->AchievedCutoffFrequencyHertz / aCutoffFrequencyHertz) - 1) * 100;
+    aBiquadDesignPtr->QErrorPercent = ((aBiquadDesignPtr->AchievedQ / aQ) - 1) * 100;
+    aBiquadDesignPtr->Int16DeadBand = 128 / tAlpha_shift8;
+    aBiquadDesignPtr->IsStable = (tAlpha_shift8 + tDampingFactor_shift8 < 512);
+}
+
+void initBiquad16(struct BiquadFilter16Struct *BiquadFilter16Ptr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ) {
+    BiquadFilter16Ptr->DampingFactor_shift8 = getBiquadDampingFactor_shift8(aQ);
+    BiquadFilter16Ptr->Alpha_shift8 = getBiquadAlpha_shift8(aSampleFrequencyHertz, aCutoffFrequencyHertz);
+}
+void initBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr, float aSampleFrequencyHertz, float aCutoffFrequencyHertz, float aQ) {
+    BiquadFilter32Ptr->DampingFactor_shift8 = getBiquadDampingFactor_shift8(aQ);
+    BiquadFilter32Ptr->Alpha_shift8 = getBiquadAlpha_shift8(aSampleFrequencyHertz, aCutoffFrequencyHertz);
+}
+
 void resetBiquad16(struct BiquadFilter16Struct *BiquadFilter16Ptr) {
     BiquadFilter16Ptr->BiQuadBandpass = 0;
     BiquadFilter16Ptr->BiQuadLowpass = 0;
@@ -405,32 +661,341 @@ void resetBiquad32(struct BiquadFilter32Struct *BiquadFilter32Ptr) {
     BiquadFilter32Ptr->BiQuadLowpass_shift8 = 0;
 }
 
+/****************************************************************
+ * Direct form I and direct form II transposed biquad functions
+ ****************************************************************/
+/*
+ * Formulas from the Audio EQ Cookbook by Robert Bristow-Johnson, normalized to A0 = 1
+ */
+void designBiquadLowpassCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aCutoffFrequencyHertz, float aQ) {
+    float tOmega = TWO_PI * aCutoffFrequencyHertz / aSampleFrequencyHertz;
+    float tCos = cos(tOmega);
+    float tAlpha = sin(tOmega) / (2 * aQ);
+    float tA0 = 1 + tAlpha;
+    aCoefficientsPtr->b1 = (1 - tCos) / tA0;
+    aCoefficientsPtr->b0 = aCoefficientsPtr->b1 / 2;
+    aCoefficientsPtr->b2 = aCoefficientsPtr->b0;
+    aCoefficientsPtr->a1 = (-2 * tCos) / tA0;
+    aCoefficientsPtr->a2 = (1 - tAlpha) / tA0;
+}
+
+void designBiquadHighpassCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aCutoffFrequencyHertz, float aQ) {
+    float tOmega = TWO_PI * aCutoffFrequencyHertz / aSampleFrequencyHertz;
+    float tCos = cos(tOmega);
+    float tAlpha = sin(tOmega) / (2 * aQ);
+    float tA0 = 1 + tAlpha;
+    aCoefficientsPtr->b1 = -(1 + tCos) / tA0;
+    aCoefficientsPtr->b0 = -aCoefficientsPtr->b1 / 2;
+    aCoefficientsPtr->b2 = aCoefficientsPtr->b0;
+    aCoefficientsPtr->a1 = (-2 * tCos) / tA0;
+    aCoefficientsPtr->a2 = (1 - tAlpha) / tA0;
+}
+
+/*
+ * @param aQ    Notch frequency / bandwidth, e.g. 10 for a 5 Hz wide notch at 50 Hz
+ */
+void designBiquadNotchCoefficients(struct BiquadCoefficientsStruct *aCoefficientsPtr, float aSampleFrequencyHertz,
+        float aNotchFrequencyHertz, float aQ) {
+    float tOmega = TWO_PI * aNotchFrequencyHertz / aSampleFrequencyHertz;
+    float tCos = cos(tOmega);
+    float tAlpha = sin(tOmega) / (2 * aQ);
+    float tA0 = 1 + tAlpha;
+    aCoefficientsPtr->b0 = 1 / tA0;
+    aCoefficientsPtr->b1 = (-2 * tCos) / tA0;
+    aCoefficientsPtr->b2 = aCoefficientsPtr->b0;
+    aCoefficientsPtr->a1 = aCoefficientsPtr->b1;
+    aCoefficientsPtr->a2 = (1 - tAlpha) / tA0;
+}
+
+/*
+ * Q of the sections of an even order Butterworth filter. 0.7071 for order 2, 0.5412 and 1.3066 for order 4.
+ * @param aSectionIndex 0 to (aOrder / 2) - 1
+ */
+float getButterworthSectionQ(uint8_t aOrder, uint8_t aSectionIndex) {
+    return 1 / (2 * cos((2 * aSectionIndex + 1) * PI / (2 * aOrder)));
+}
+
+/*
+ * Rounds to nearest and saturates
+ */
+int16_t quantizeBiquadCoefficientQ14(float aCoefficient) {
+    float tValue = aCoefficient * 16384;
+    if (tValue >= 32767) {
+        return 32767;
+    }
+    if (tValue <= -32768) {
+        return -32768;
+    }
+    return (int16_t) lround(tValue);
+}
+int32_t quantizeBiquadCoefficientQ30(float aCoefficient) {
+    float tValue = aCoefficient * 1073741824.0;
+    if (tValue >= 2147483647.0) {
+        return 2147483647L;
+    }
+    if (tValue <= -2147483648.0) {
+        return -2147483647L - 1;
+    }
+    return lround(tValue);
+}
+
+/*
+ * Quantizes one coefficient and updates the maximum absolute quantization error
+ */
+static int16_t quantizeBiquadCoefficientQ14(float aCoefficient, float *aMaximumErrorPtr) {
+    int16_t tQ14Coefficient = quantizeBiquadCoefficientQ14(aCoefficient);
+    float tError = fabs(aCoefficient - (tQ14Coefficient / 16384.0));
+    if (*aMaximumErrorPtr < tError) {
+        *aMaximumErrorPtr = tError;
+    }
+    return tQ14Coefficient;
+}
+static int32_t quantizeBiquadCoefficientQ30(float aCoefficient, float *aMaximumErrorPtr) {
+    int32_t tQ30Coefficient = quantizeBiquadCoefficientQ30(aCoefficient);
+    float tError = fabs(aCoefficient - (tQ30Coefficient / 1073741824.0));
+    if (*aMaximumErrorPtr < tError) {
+        *aMaximumErrorPtr = tError;
+    }
+    return tQ30Coefficient;
+}
+
+/*
+ * @return The maximum absolute quantization error of the 5 coefficients, e.g. to decide between Q15 and Q31 filters
+ */
+float quantizeBiquadCoefficientsQ14(struct BiquadCoefficientsQ14Struct *aQ14CoefficientsPtr,
+        const struct BiquadCoefficientsStruct *aCoefficientsPtr) {
+    float tMaximumError = 0;
+    aQ14CoefficientsPtr->b0 = quantizeBiquadCoefficientQ14(aCoefficientsPtr->b0, &tMaximumError);
+    aQ14CoefficientsPtr->b1 = quantizeBiquadCoefficientQ14(aCoefficientsPtr->b1, &tMaximumError);
+    aQ14CoefficientsPtr->b2 = quantizeBiquadCoefficientQ14(aCoefficientsPtr->b2, &tMaximumError);
+    aQ14CoefficientsPtr->a1 = quantizeBiquadCoefficientQ14(aCoefficientsPtr->a1, &tMaximumError);
+    aQ14CoefficientsPtr->a2 = quantizeBiquadCoefficientQ14(aCoefficientsPtr->a2, &tMaximumError);
+    return tMaximumError;
+}
+float quantizeBiquadCoefficientsQ30(struct BiquadCoefficientsQ30Struct *aQ30CoefficientsPtr,
+        const struct BiquadCoefficientsStruct *aCoefficientsPtr) {
+    float tMaximumError = 0;
+    aQ30CoefficientsPtr->b0 = quantizeBiquadCoefficientQ30(aCoefficientsPtr->b0, &tMaximumError);
+    aQ30CoefficientsPtr->b1 = quantizeBiquadCoefficientQ30(aCoefficientsPtr->b1, &tMaximumError);
+    aQ30CoefficientsPtr->b2 = quantizeBiquadCoefficientQ30(aCoefficientsPtr->b2, &tMaximumError);
+    aQ30CoefficientsPtr->a1 = quantizeBiquadCoefficientQ30(aCoefficientsPtr->a1, &tMaximumError);
+    aQ30CoefficientsPtr->a2 = quantizeBiquadCoefficientQ30(aCoefficientsPtr->a2, &tMaximumError);
+    return tMaximumError;
+}
+
+int16_t saturateToInt16(int32_t aValue) {
+    if (aValue > 32767) {
+        return 32767;
+    }
+    if (aValue < -32768) {
+        return -32768;
+    }
+    return aValue;
+}
+int32_t saturateToInt32(int64_t aValue) {
+    if (aValue > 2147483647L) {
+        return 2147483647L;
+    }
+    if (aValue < -2147483647L - 1) {
+        return -2147483647L - 1;
+    }
+    return aValue;
+}
+
+/*
+ * @return The 14 fraction bits of aAccumulator removed by rounding to aOutputValue. 0 if the output is saturated,
+ *         since the difference is then no rounding error and would be fed back to an already limited output.
+ */
+static int16_t getBiquadQ15RoundingError(int32_t aAccumulator, int16_t aOutputValue) {
+    int32_t tRoundingError = aAccumulator - ((int32_t) aOutputValue << 14);
+    if (tRoundingError < -(1 << 13) || tRoundingError >= (1 << 13)) {
+        return 0;
+    }
+    return tRoundingError;
+}
+
+/*
+ * Direct form I has only one accumulator, so only the output must be saturated. 6 values of state.
+ * The fraction bits removed by rounding the output are fed back too (error feedback),
+ * otherwise the output sticks in a dead band of around 0.5 / (1 + a1 + a2) and does not settle.
+ */
+int16_t doBiquadDF1_Q15(struct BiquadDF1Q15Struct *aBiquadPtr, int16_t aInputValue) {
+    struct BiquadCoefficientsQ14Struct *tCoefficients = &aBiquadPtr->Coefficients;
+    int32_t tAccumulator = (int32_t) tCoefficients->b0 * aInputValue + (int32_t) tCoefficients->b1 * aBiquadPtr->X1
+            + (int32_t) tCoefficients->b2 * aBiquadPtr->X2 - (int32_t) tCoefficients->a1 * aBiquadPtr->Y1
+            - (int32_t) tCoefficients->a2 * aBiquadPtr->Y2
+            - (((int32_t) tCoefficients->a1 * aBiquadPtr->E1 + (int32_t) tCoefficients->a2 * aBiquadPtr->E2) >> 14);
+    int16_t tOutputValue = saturateToInt16((tAccumulator + (1 << 13)) >> 14);
+    aBiquadPtr->X2 = aBiquadPtr->X1;
+    aBiquadPtr->X1 = aInputValue;
+    aBiquadPtr->Y2 = aBiquadPtr->Y1;
+    aBiquadPtr->Y1 = tOutputValue;
+    aBiquadPtr->E2 = aBiquadPtr->E1;
+    aBiquadPtr->E1 = getBiquadQ15RoundingError(tAccumulator, tOutputValue);
+    return tOutputValue;
+}
+
+/*
+ * Direct form II transposed has only 2 values of state, which keep the 14 fraction bits of the products.
+ * Like for DF1, the fraction bits removed by rounding the output are fed back, otherwise the state gains nothing.
+ */
+int16_t doBiquadDF2T_Q15(struct BiquadDF2TQ15Struct *aBiquadPtr, int16_t aInputValue) {
+    struct BiquadCoefficientsQ14Struct *tCoefficients = &aBiquadPtr->Coefficients;
+    int32_t tAccumulator = (int32_t) tCoefficients->b0 * aInputValue + aBiquadPtr->S1_Q29;
+    int16_t tOutputValue = saturateToInt16((tAccumulator + (1 << 13)) >> 14);
+    int16_t tRoundingError = getBiquadQ15RoundingError(tAccumulator, tOutputValue);
+    aBiquadPtr->S1_Q29 = (int32_t) tCoefficients->b1 * aInputValue - (int32_t) tCoefficients->a1 * tOutputValue
+            - (((int32_t) tCoefficients->a1 * tRoundingError) >> 14) + aBiquadPtr->S2_Q29;
+    aBiquadPtr->S2_Q29 = (int32_t) tCoefficients->b2 * aInputValue - (int32_t) tCoefficients->a2 * tOutputValue
+            - (((int32_t) tCoefficients->a2 * tRoundingError) >> 14);
+    return tOutputValue;
+}
+
+int32_t doBiquadDF1_Q31(struct BiquadDF1Q31Struct *aBiquadPtr, int32_t aInputValue) {
+    struct BiquadCoefficientsQ30Struct *tCoefficients = &aBiquadPtr->Coefficients;
+    int64_t tAccumulator = (int64_t) tCoefficients->b0 * aInputValue + (int64_t) tCoefficients->b1 * aBiquadPtr->X1
+            + (int64_t) tCoefficients->b2 * aBiquadPtr->X2 - (int64_t) tCoefficients->a1 * aBiquadPtr->Y1
+            - (int64_t) tCoefficients->a2 * aBiquadPtr->Y2;
+    int32_t tOutputValue = saturateToInt32((tAccumulator + (1L << 29)) >> 30);
+    aBiquadPtr->X2 = aBiquadPtr->X1;
+    aBiquadPtr->X1 = aInputValue;
+    aBiquadPtr->Y2 = aBiquadPtr->Y1;
+    aBiquadPtr->Y1 = tOutputValue;
+    return tOutputValue;
+}
+
+int32_t doBiquadDF2T_Q31(struct BiquadDF2TQ31Struct *aBiquadPtr, int32_t aInputValue) {
+    struct BiquadCoefficientsQ30Struct *tCoefficients = &aBiquadPtr->Coefficients;
+    int32_t tOutputValue = saturateToInt32(((int64_t) tCoefficients->b0 * aInputValue + aBiquadPtr->S1_Q61 + (1L << 29)) >> 30);
+    aBiquadPtr->S1_Q61 = (int64_t) tCoefficients->b1 * aInputValue - (int64_t) tCoefficients->a1 * tOutputValue
+            + aBiquadPtr->S2_Q61;
+    aBiquadPtr->S2_Q61 = (int64_t) tCoefficients->b2 * aInputValue - (int64_t) tCoefficients->a2 * tOutputValue;
+    return tOutputValue;
+}
+
+/*
+ * Second order sections. The output of a section is the input of the next one.
+ */
+int16_t doBiquadSOSDF1_Q15(struct BiquadDF1Q15Struct *aSectionArray, uint8_t aNumberOfSections, int16_t aInputValue) {
+    for (uint_fast8_t i = 0; i < aNumberOfSections; ++i) {
+        aInputValue = doBiquadDF1_Q15(&aSectionArray[i], aInputValue);
+    }
+    return aInputValue;
+}
+int16_t doBiquadSOSDF2T_Q15(struct BiquadDF2TQ15Struct *aSectionArray, uint8_t aNumberOfSections, int16_t aInputValue) {
+    for (uint_fast8_t i = 0; i < aNumberOfSections; ++i) {
+        aInputValue = doBiquadDF2T_Q15(&aSectionArray[i], aInputValue);
+    }
+    return aInputValue;
+}
+int32_t doBiquadSOSDF1_Q31(struct BiquadDF1Q31Struct *aSectionArray, uint8_t aNumberOfSections, int32_t aInputValue) {
+    for (uint_fast8_t i = 0; i < aNumberOfSections; ++i) {
+        aInputValue = doBiquadDF1_Q31(&aSectionArray[i], aInputValue);
+    }
+    return aInputValue;
+}
+int32_t doBiquadSOSDF2T_Q31(struct BiquadDF2TQ31Struct *aSectionArray, uint8_t aNumberOfSections, int32_t aInputValue) {
+    for (uint_fast8_t i = 0; i < aNumberOfSections; ++i) {
+        aInputValue = doBiquadDF2T_Q31(&aSectionArray[i], aInputValue);
+    }
+    return aInputValue;
+}
+
+/*
+ * Exchanges the values if aValue0 > aValue1
+ */
+static inline void sort2(int16_t &aValue0, int16_t &aValue1) {
+    if (aValue0 > aValue1) {
+        int16_t tTemp = aValue0;
+        aValue0 = aValue1;
+        aValue1 = tTemp;
+    }
+}
+
+/*
+ * 3 comparisons
+ */
+int16_t getMedianOf3(int16_t aValue0, int16_t aValue1, int16_t aValue2) {
+    sort2(aValue0, aValue1);
+    sort2(aValue1, aValue2);
+    sort2(aValue0, aValue1);
+    return aValue1;
+}
+
+/*
+ * 7 comparisons
+ */
+int16_t getMedianOf5(int16_t *aValues) {
+    sort2(aValues[0], aValues[1]);
+    sort2(aValues[3], aValues[4]);
+    sort2(aValues[0], aValues[3]);
+    sort2(aValues[1], aValues[4]);
+    sort2(aValues[1], aValues[2]);
+    sort2(aValues[2], aValues[3]);
+    sort2(aValues[1], aValues[2]);
+    return aValues[2];
+}
+
+/*
+ * 13 comparisons
+ */
+int16_t getMedianOf7(int16_t *aValues) {
+    sort2(aValues[0], aValues[5]);
+    sort2(aValues[0], aValues[3]);
+    sort2(aValues[1], aValues[6]);
+    sort2(aValues[2], aValues[4]);
+    sort2(aValues[0], aValues[1]);
+    sort2(aValues[3], aValues[5]);
+    sort2(aValues[2], aValues[6]);
+    sort2(aValues[2], aValues[3]);
+    sort2(aValues[3], aValues[6]);
+    sort2(aValues[4], aValues[5]);
+    sort2(aValues[1], aValues[4]);
+    sort2(aValues[1], aValues[3]);
+    sort2(aValues[3], aValues[4]);
+    return aValues[3];
+}
+
 /*****************
  * Demo functions
  *****************/
 
-void resetFilters() {
-    sLowpass1 = 0;
-    sLowpass2 = 0;
-    sLowpass3 = 0;
-    sLowpass4 = 0;
-    sLowpass5 = 0;
+template<uint8_t NumberOfChannels>
+void EMAFilterBank<NumberOfChannels>::reset() {
+    for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+        InputValue[i] = 0;
+
+        Lowpass1[i] = 0;
+        Lowpass2[i] = 0;
+        Lowpass3[i] = 0;
+        Lowpass4[i] = 0;
+        Lowpass5[i] = 0;
 
-    sDoubleLowpass3 = 0;
-    sDoubleLowpass4 = 0;
-    sDoubleLowpass5 = 0;
+        DoubleLowpass3[i] = 0;
+        DoubleLowpass4[i] = 0;
+        DoubleLowpass5[i] = 0;
 
-    sTripleLowpass3 = 0;
+        TripleLowpass3[i] = 0;
 
-    sLowpass3_int32_shift8 = 0;
-    sLowpass5_int32_shift8 = 0;
-    sLowpass8_int32_shift8 = 0;
+        Lowpass3_int32_shift8[i] = 0;
+        Lowpass5_int32_shift8[i] = 0;
+        Lowpass8_int32_shift8[i] = 0;
 
-    sLowpass5_float = 0;
-    sLowpass8_float = 0;
+        Lowpass5_float[i] = 0;
+        Lowpass8_float[i] = 0;
 
-    resetBiquad16(&sBiQuad_int16);
-    resetBiquad32(&sBiQuad_int32);
+        // set Biquad filter coefficients
+        initBiquad16(&BiQuad_int16[i], 256, 32); // damping factor 1 -> damping, 64 ->shift 2
+        initBiquad32(&BiQuad_int32[i], 64, 32); // damping factor 1/4 -> low damping, 32 ->shift 3
+        resetBiquad16(&BiQuad_int16[i]);
+        resetBiquad32(&BiQuad_int32[i]);
+    }
+}
+
+void resetFilters() {
+    sFilterBank.reset();
 }
 
 /*
@@ -494,6 +1059,21 @@ void doFiltersTimingTest(int16_t aInputValue) {
     timingPinLow();timingPinHigh();
     doLowpass_int16(&sLowpass5, aInputValue, 4);        // us  - 4 = 1/64 = >>6
 
+    /*
+     * Cascade template and the hand coded functions, which are wrappers around it.
+     * The values are estimated from the single stage timings and still need to be measured.
+     */
+    timingPinLow();
+    delayMicroseconds(5);
+    timingPinHigh();
+    doDoubleLowpass3_int16(&sLowpass3, &sDoubleLowpass3, aInputValue);                 // ~4.0 us estimated, 2 * doLowpass3_int16()
+    timingPinLow();timingPinHigh();
+    doTripleLowpass3_int16(&sLowpass3, &sDoubleLowpass3, &sTripleLowpass3, aInputValue); // ~6.0 us estimated, 3 * doLowpass3_int16()
+    timingPinLow();timingPinHigh();
+    sTripleLowpass3Cascade.update(aInputValue);                                         // same code as doTripleLowpass3_int16()
+    timingPinLow();timingPinHigh();
+    sDoubleLowpass5Cascade_int32.update(aInputValue);                                   // ~7.9 us estimated, 2 * doLowpass5_int32_shift8()
+
     /*
      * 32 bit functions / fixed point
      */
@@ -519,7 +1099,7 @@ void doFiltersTimingTest(int16_t aInputValue) {
     sLowpass8_int32_shift8 += (tInputValue32_shift8 - sLowpass8_int32_shift8) >> 8; // 2.13 us
 
     /*
-     * 32 bit generic functions
+     * 32 bit generic functions. The doLowpass_int32_shift8() timings were measured with the C version before the assembler kernels.
      */
     timingPinLow();
     delayMicroseconds(5);
@@ -559,7 +1139,67 @@ void doFiltersTimingTest(int16_t aInputValue) {
     timingPinHigh();
     doBiquad_int16(&sBiQuad_int16, aInputValue);    // 12.94 us - damping factor 1 -> damping, 64 ->shift 2
     timingPinLow();timingPinHigh();
-    doBiquad_int32(&sBiQuad_int32, aInputValue);    // 21.81 us - damping factor 1/4 -> low damping, 32 ->shift 3
+    doBiquad_int32(&sBiQuad_int32, aInputValue);    // not yet measured - damping factor 1/4 -> low damping, 32 ->shift 3
+    timingPinLow();timingPinHigh();
+    doBiquad_int32_C(&sBiQuad_int32, aInputValue);  // 21.81 us - C reference, measured for doBiquad_int32() before the assembler kernels
+
+    /*
+     * Direct form biquads
+     */
+    timingPinLow();
+    struct BiquadCoefficientsStruct tCoefficients;
+    designBiquadLowpassCoefficients(&tCoefficients, 1000, 20, getButterworthSectionQ(4, 0));
+    quantizeBiquadCoefficientsQ14(&sBiquadDF1_Q15[0].Coefficients, &tCoefficients);
+    quantizeBiquadCoefficientsQ30(&sBiquadDF1_Q31.Coefficients, &tCoefficients);
+    quantizeBiquadCoefficientsQ30(&sBiquadDF2T_Q31.Coefficients, &tCoefficients);
+    designBiquadLowpassCoefficients(&tCoefficients, 1000, 20, getButterworthSectionQ(4, 1));
+    quantizeBiquadCoefficientsQ14(&sBiquadDF1_Q15[1].Coefficients, &tCoefficients);
+    designBiquadNotchCoefficients(&tCoefficients, 1000, 50, 10);
+    quantizeBiquadCoefficientsQ14(&sBiquadDF2T_Q15.Coefficients, &tCoefficients);
+    delayMicroseconds(5);
+    timingPinHigh();
+    doBiquadDF1_Q15(&sBiquadDF1_Q15[0], aInputValue);           // not yet measured - 7 16 x 16 bit multiplications
+    timingPinLow();timingPinHigh();
+    doBiquadDF2T_Q15(&sBiquadDF2T_Q15, aInputValue);            // not yet measured - 7 16 x 16 bit multiplications
+    timingPinLow();timingPinHigh();
+    doBiquadSOSDF1_Q15(sBiquadDF1_Q15, 2, aInputValue);         // not yet measured - 2 * doBiquadDF1_Q15(), 4. order Butterworth
+    timingPinLow();timingPinHigh();
+    doBiquadDF1_Q31(&sBiquadDF1_Q31, (int32_t) aInputValue << 16);   // not yet measured - 5 64 bit multiplications
+    timingPinLow();timingPinHigh();
+    doBiquadDF2T_Q31(&sBiquadDF2T_Q31, (int32_t) aInputValue << 16); // not yet measured - 5 64 bit multiplications
+
+    /*
+     * Moving average and median
+     */
+    timingPinLow();
+    sMovingAverage16.reset();
+    sMedian5.reset();
+    sMedian15.reset();
+    delayMicroseconds(5);
+    timingPinHigh();
+    sMovingAverage16.update(aInputValue);                       // not yet measured - 1 addition and 1 subtraction, independent of window size
+    timingPinLow();timingPinHigh();
+    getMedianOf3(aInputValue, 0, -aInputValue);                 // not yet measured - 3 compare and exchange
+    timingPinLow();timingPinHigh();
+    sMedian5.update(aInputValue);                               // not yet measured - copy of 5 values and 7 compare and exchange
+    timingPinLow();timingPinHigh();
+    sMedian15.update(aInputValue);                              // not yet measured - 4 binary search steps and 14 moves for aInputValue > 0 after reset
+
+    /*
+     * C reference versions of the functions using assembler kernels.
+     * The timings of the C versions were measured before the assembler kernels were added.
+     * The kernels can be checked bit-exact against the C versions with extras/FilterKernelCheck.
+     */
+    timingPinLow();
+    delayMicroseconds(5);
+    timingPinHigh();
+    doLowpass_int32_shift8(&sLowpass5_int32_shift8, aInputValue, 8);    // not yet measured, 21 cycles kernel - 8 = 1/32 = >>5
+    timingPinLow();timingPinHigh();
+    doLowpass_int32_shift8_C(&sLowpass5_int32_shift8, aInputValue, 8);  // 7.13 us
+    timingPinLow();timingPinHigh();
+    doLowpass8_int32_shift16(&sLowpass8_int32_shift8, aInputValue);     // not yet measured, 6 cycles kernel
+    timingPinLow();timingPinHigh();
+    doLowpass8_int32_shift16_C(&sLowpass8_int32_shift8, aInputValue);   // 2.13 us, same expression as the >> 8 for sLowpass8_int32_shift8 above
 
     timingPinLow();
     interrupts();
@@ -567,81 +1207,99 @@ void doFiltersTimingTest(int16_t aInputValue) {
 }
 
 /*
- * The main demo function
+ * Computes the filters required for aFilterMask for all channels.
+ * @param aInputValues  One value for each channel
  */
-void doFiltersStep(int16_t aInputValue) {
-    // set Biquad filter coefficients
-    initBiquad16(&sBiQuad_int16, 256, 32); // damping factor 1 -> damping, 64 ->shift 2
-    initBiquad32(&sBiQuad_int32, 64, 32); // damping factor 1/4 -> low damping, 32 ->shift 3
-
-    sInputValueForPrint = aInputValue;
+template<uint8_t NumberOfChannels>
+void EMAFilterBank<NumberOfChannels>::doStep(const int16_t *aInputValues, uint32_t aFilterMask) {
+    for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+        InputValue[i] = aInputValues[i];
+    }
 
     /*
      * int16_t low pass values
      */
-    sLowpass1 += (aInputValue - sLowpass1) >> 1; // 1 us, alpha = 0.5, cutoff frequency 160 Hz @1kHz sampling rate
-
-// "+ (1 << 2)" to avoid to much rounding errors and it costs only 1 clock extra
-//    sLowpass2 += ((aInputValue - sLowpass2) + (1 << 1)) >> 2; // 1.1 us, alpha = 0.25, cutoff frequency 53 Hz @1kHz
-//    doLowpass2_int16(&sLowpass2, aInputValue);
-//    replaced by generic function:
-    doLowpass_int16(&sLowpass2, aInputValue, 64); //64 = 1/4 = >>2
-
-//    sLowpass3 += ((aInputValue - sLowpass3) + (1 << 2)) >> 3; // 1.8 us, alpha = 0.125, cutoff frequency 22.7 Hz @1kHz
-//    sDoubleLowpass3 += ((sLowpass3 - sDoubleLowpass3) + (1 << 2)) >> 3;
-// replaced by:
-//    doLowpass3_int16(&sLowpass3, aInputValue);
-//    doLowpass3_int16(&sDoubleLowpass3, sLowpass3);
-// replaced by fixed function:
-    doDoubleLowpass3_int16(&sLowpass3, &sDoubleLowpass3, aInputValue);
-
-//    sTripleLowpass3 += ((sDoubleLowpass3 - sTripleLowpass3) + (1 << 2)) >> 3;
-    doLowpass3_int16(&sTripleLowpass3, sDoubleLowpass3);
-
-//    sLowpass4 += ((aInputValue - sLowpass4) + (1 << 3)) >> 4; // 2.2 us, alpha = 0.0625, cutoff frequency 10.6 Hz @1kHz
-    doLowpass4_int16(&sLowpass4, aInputValue);
-//    sDoubleLowpass4 += ((sLowpass4 - sDoubleLowpass4) + (1 << 3)) >> 4;
-    doLowpass4_int16(&sDoubleLowpass4, sLowpass4);
-
-//    sLowpass5 += ((aInputValue - sLowpass5) + (1 << 4)) >> 5; // 2.5 us, alpha = 1/32 0.03125, cutoff frequency 5.13 Hz @1kHz
-    doLowpass5_int16(&sLowpass5, aInputValue);
-//    sDoubleLowpass5 += ((sLowpass5 - sDoubleLowpass5) + (1 << 4)) >> 5;
-    doLowpass5_int16(&sDoubleLowpass5, sLowpass5);
-
-    /*
-     * int32_t low pass values for higher exponents
-     */
-//    int32_t tInputValue32_shift8 = (int32_t) aInputValue << 8;
-//    sLowpass3_int32_shift8 += (tInputValue32_shift8 - sLowpass3_int32_shift8) >> 3; // Fixed point
-//    doLowpass3_int32_shift8(&sLowpass3_int32_shift8, aInputValue);
-//    replaced by generic function:
-    doLowpassShift_int32_shift8(&sLowpass3_int32_shift8, aInputValue, 3);
+    if (aFilterMask & FILTER_BANK_LP_1_MASK) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            Lowpass1[i] += (aInputValues[i] - Lowpass1[i]) >> 1; // 1 us, alpha = 0.5, cutoff frequency 160 Hz @1kHz sampling rate
+        }
+    }
+    if (aFilterMask & PRINT_LP_2) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass_int16(&Lowpass2[i], aInputValues[i], 64); //64 = 1/4 = >>2
+        }
+    }
+    if (aFilterMask & FILTER_BANK_LP_3_MASK) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doDoubleLowpass3_int16(&Lowpass3[i], &DoubleLowpass3[i], aInputValues[i]);
+            doLowpass3_int16(&TripleLowpass3[i], DoubleLowpass3[i]);
+        }
+    }
+    if (aFilterMask & FILTER_BANK_LP_4_MASK) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doDoubleLowpass4_int16(&Lowpass4[i], &DoubleLowpass4[i], aInputValues[i]);
+        }
+    }
+    if (aFilterMask & FILTER_BANK_LP_5_MASK) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass5_int16(&Lowpass5[i], aInputValues[i]);
+            doLowpass5_int16(&DoubleLowpass5[i], Lowpass5[i]);
+        }
+    }
 
     /*
-     * int32_t low pass values for higher resolution
+     * int32_t low pass values for higher exponents and higher resolution
      */
-//    sLowpass5_int32_shift8 += (tInputValue32_shift8 - sLowpass5_int32_shift8) >> 5; // Fixed point 4.2 us
-//    replaced by generic function:
-    doLowpass_int32_shift8(&sLowpass5_int32_shift8, aInputValue, 8);
-
-// alpha = 1/256 = 0.0039, cutoff frequency 0.624 Hz @1kHz
-//    sLowpass8_int32_shift8 += ((tInputValue32_shift8 - sLowpass8_int32_shift8) + (1 << 7)) >> 8; // Fixed point 2.0 us because of fast shift :-)
-    doLowpass8_int32_shift8(&sLowpass8_int32_shift8, aInputValue);
+    if (aFilterMask & PRINT_LP_3_32) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpassShift_int32_shift8(&Lowpass3_int32_shift8[i], aInputValues[i], 3);
+        }
+    }
+    if (aFilterMask & PRINT_LP_5_32) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass_int32_shift8(&Lowpass5_int32_shift8[i], aInputValues[i], 8);
+        }
+    }
+    if (aFilterMask & PRINT_LP_8_32) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass8_int32_shift8(&Lowpass8_int32_shift8[i], aInputValues[i]); // alpha = 1/256 = 0.0039, cutoff frequency 0.624 Hz @1kHz
+        }
+    }
 
     /*
      * float low pass values with exponent 5 and 8
      */
-//    sLowpass5_float += (aInputValue - sLowpass5_float) / 32.0; // 24 to 34 us
-    doLowpass5_float(&sLowpass5_float, aInputValue);
-
-//    sLowpass8_float += (aInputValue - sLowpass8_float) / 256.0;
-    doLowpass8_float(&sLowpass8_float, aInputValue);
+    if (aFilterMask & PRINT_LP_5_FLOAT) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass5_float(&Lowpass5_float[i], aInputValues[i]);
+        }
+    }
+    if (aFilterMask & PRINT_LP_8_FLOAT) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doLowpass8_float(&Lowpass8_float[i], aInputValues[i]);
+        }
+    }
 
     /*
      * Biquad or State Variable Filter
      */
-    doBiquad_int16(&sBiQuad_int16, aInputValue);
-    doBiquad_int32(&sBiQuad_int32, aInputValue);
+    if (aFilterMask & PRINT_BI_QUAD_16) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doBiquad_int16(&BiQuad_int16[i], aInputValues[i]);
+        }
+    }
+    if (aFilterMask & PRINT_BI_QUAD_32) {
+        for (uint_fast8_t i = 0; i < NumberOfChannels; ++i) {
+            doBiquad_int32(&BiQuad_int32[i], aInputValues[i]);
+        }
+    }
+}
+
+/*
+ * The main demo function. Computes all filters for one signal.
+ */
+void doFiltersStep(int16_t aInputValue) {
+    sFilterBank.doStep(&aInputValue);
 }
 
 /************************
@@ -742,120 +1400,125 @@ void printFiltersCaption(uint8_t aFilterSelection) {
     Serial.println(F("__"));
 }
 
-void printFiltersResults(uint32_t aPrintMask) {
-    Serial.print(sInputValueForPrint);
+template<uint8_t NumberOfChannels>
+void EMAFilterBank<NumberOfChannels>::printResults(uint8_t aChannel, uint32_t aPrintMask) {
+    Serial.print(InputValue[aChannel]);
     Serial.print(" ");
 
     if (aPrintMask & PRINT_LP_1) {
-        Serial.print(sLowpass1);
+        Serial.print(Lowpass1[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_2) {
-        Serial.print(sLowpass2);
+        Serial.print(Lowpass2[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_3) {
-        Serial.print(sLowpass3);
+        Serial.print(Lowpass3[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_3_32) {
-        Serial.print(sLowpass3_int32_shift8 >> 8);
+        Serial.print(Lowpass3_int32_shift8[aChannel] >> 8);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_DOUBLE_LP_3) {
-        Serial.print(sDoubleLowpass3);
+        Serial.print(DoubleLowpass3[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_TRIPLE_LP_3) {
-        Serial.print(sTripleLowpass3);
+        Serial.print(TripleLowpass3[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_4) {
-        Serial.print(sLowpass4);
+        Serial.print(Lowpass4[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_DOUBLE_LP_4) {
-        Serial.print(sDoubleLowpass4);
+        Serial.print(DoubleLowpass4[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_5) {
-        Serial.print(sLowpass5);
+        Serial.print(Lowpass5[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_5_32) {
-        Serial.print(sLowpass5_int32_shift8 >> 8);
+        Serial.print(Lowpass5_int32_shift8[aChannel] >> 8);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_5_FLOAT) {
-        Serial.print(sLowpass5_float);
+        Serial.print(Lowpass5_float[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_8_32) {
-        Serial.print(sLowpass8_int32_shift8 >> 8);
+        Serial.print(Lowpass8_int32_shift8[aChannel] >> 8);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_LP_8_FLOAT) {
-        Serial.print(sLowpass8_float);
+        Serial.print(Lowpass8_float[aChannel]);
         Serial.print(" ");
     }
 
     if (aPrintMask & PRINT_HIGH_PASS_1_16) {
-        Serial.print(sInputValueForPrint - sLowpass1);
+        Serial.print(InputValue[aChannel] - Lowpass1[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_HIGH_PASS_3_16) {
-        Serial.print(sInputValueForPrint - sLowpass3);
+        Serial.print(InputValue[aChannel] - Lowpass3[aChannel]);
         Serial.print(" ");
     }
 
     if (aPrintMask & PRINT_BAND_PASS_1_3) {
-        Serial.print(sLowpass1 - sLowpass3);
+        Serial.print(Lowpass1[aChannel] - Lowpass3[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BAND_PASS_1_5) {
-        Serial.print(sLowpass1 - sLowpass5);
+        Serial.print(Lowpass1[aChannel] - Lowpass5[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BAND_PASS_3_4) {
-        Serial.print(sLowpass3 - sLowpass4);
+        Serial.print(Lowpass3[aChannel] - Lowpass4[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BAND_PASS_3_5) {
-        Serial.print(sLowpass3 - sLowpass5);
+        Serial.print(Lowpass3[aChannel] - Lowpass5[aChannel]);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BAND_STOP_3_4) {
-        Serial.print(sInputValueForPrint - (sLowpass3 - sLowpass4));
+        Serial.print(InputValue[aChannel] - (Lowpass3[aChannel] - Lowpass4[aChannel]));
         Serial.print(" ");
     }
 
     if (aPrintMask & PRINT_BQ_LP_16) {
-        Serial.print(sBiQuad_int16.BiQuadLowpass);
+        Serial.print(BiQuad_int16[aChannel].BiQuadLowpass);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BQ_HP_16) {
-        Serial.print(sBiQuad_int16.BiQuadHighpass);
+        Serial.print(BiQuad_int16[aChannel].BiQuadHighpass);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BQ_BP_16) {
-        Serial.print(sBiQuad_int16.BiQuadBandpass);
+        Serial.print(BiQuad_int16[aChannel].BiQuadBandpass);
         Serial.print(" ");
     }
 
     if (aPrintMask & PRINT_BQ_LP_32) {
-        Serial.print(sBiQuad_int32.BiQuadLowpass_shift8 >> 8);
+        Serial.print(BiQuad_int32[aChannel].BiQuadLowpass_shift8 >> 8);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BQ_HP_32) {
-        Serial.print(sBiQuad_int32.BiQuadHighpass_shift8 >> 8);
+        Serial.print(BiQuad_int32[aChannel].BiQuadHighpass_shift8 >> 8);
         Serial.print(" ");
     }
     if (aPrintMask & PRINT_BQ_BP_32) {
-        Serial.print(sBiQuad_int32.BiQuadBandpass_shift8 >> 8);
+        Serial.print(BiQuad_int32[aChannel].BiQuadBandpass_shift8 >> 8);
         Serial.print(" ");
     }
 
     Serial.println();
 }
 
+void printFiltersResults(uint32_t aPrintMask) {
+    sFilterBank.printResults(0, aPrintMask);
+}
+
 #endif // _SIMPLE_EMA_FILTERS_HPP